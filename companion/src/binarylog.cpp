@@ -0,0 +1,190 @@
+#include "binarylog.h"
+#include <QtEndian>
+
+struct BinaryLogField {
+  QString name;
+  int prec;
+  int kind;
+  int column;   // column in the rows, -1 for the time field
+};
+
+bool isBinaryLog(const QString & fileName)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  return file.read(4) == BINARYLOG_MAGIC;
+}
+
+static QString formatValue(qint32 value, int prec)
+{
+  if (prec == 0) {
+    return QString::number(value);
+  }
+  int divisor = (prec == 1 ? 10 : 100);
+  QString result = QString("%1.%2").arg(qAbs(value) / divisor).arg(qAbs(value) % divisor, prec, 10, QChar('0'));
+  return (value < 0 ? "-" + result : result);
+}
+
+// same format as the CSV logs, the longitude first, ddmm.mmmm
+static QString formatGpsCoordinate(qint32 value, char positive, char negative)
+{
+  quint32 absolute = qAbs(value);
+  quint32 minutes = (absolute % 1000000) * 3 / 5;   // 1/10000 of minute
+  quint32 bp = (absolute / 1000000) * 100 + minutes / 10000;
+  return QString("%1.%2%3").arg(bp, 3, 10, QChar('0')).arg(minutes % 10000, 4, 10, QChar('0')).arg(value < 0 ? negative : positive);
+}
+
+bool readBinaryLog(const QString & fileName, QList<QStringList> & rows, QString & error)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    error = file.errorString();
+    return false;
+  }
+
+  QByteArray data = file.readAll();
+  const uchar * buffer = (const uchar *)data.constData();
+  int size = data.size();
+  int pos = 0;
+
+  QStringList header;
+  header << "Date" << "Time";
+  rows.clear();
+
+  QList<BinaryLogField> fields;
+  QVector<qint32> values;
+  QDateTime startTime;
+  qint32 startTicks = 0;
+  bool started = false;
+
+  while (pos < size) {
+    if (pos + 4 <= size && data.mid(pos, 4) == BINARYLOG_MAGIC) {
+      if (pos + BINARYLOG_HEADER_SIZE > size) {
+        break;
+      }
+      int version = buffer[pos+4];
+      int count = buffer[pos+5];
+      quint32 time = qFromLittleEndian<quint32>(buffer+pos+8);
+      if (version != BINARYLOG_VERSION) {
+        error = QObject::tr("Unsupported binary log version %1").arg(version);
+        return false;
+      }
+      pos += BINARYLOG_HEADER_SIZE;
+      if (pos + count*BINARYLOG_FIELD_SIZE > size) {
+        break;
+      }
+
+      fields.clear();
+      QSet<int> usedColumns;
+      for (int i=0; i<count; i++, pos+=BINARYLOG_FIELD_SIZE) {
+        BinaryLogField field;
+        QString name = QString::fromLatin1((const char *)buffer+pos, qstrnlen((const char *)buffer+pos, 8)).trimmed();
+        QString unit = QString::fromLatin1((const char *)buffer+pos+8, qstrnlen((const char *)buffer+pos+8, 4)).trimmed();
+        field.name = unit.isEmpty() ? name : QString("%1(%2)").arg(name).arg(unit);
+        field.prec = buffer[pos+12];
+        field.kind = buffer[pos+13];
+        field.column = -1;
+        if (field.kind == BINARYLOG_FIELD_LONGITUDE && !fields.isEmpty() && fields.last().kind == BINARYLOG_FIELD_LATITUDE) {
+          // the latitude and longitude share the same column
+          field.column = fields.last().column;
+        }
+        else if (field.kind != BINARYLOG_FIELD_TIME) {
+          // the sessions are merged on the fields names
+          field.column = header.indexOf(field.name);
+          if (field.column < 0 || usedColumns.contains(field.column)) {
+            header << field.name;
+            field.column = header.count() - 1;
+          }
+          usedColumns.insert(field.column);
+        }
+        fields.append(field);
+      }
+
+      values.fill(0, count);
+      startTime = time ? QDateTime::fromTime_t(time).toUTC() : QDateTime(QDate(1970, 1, 1), QTime(0, 0), Qt::UTC);
+      started = false;
+      continue;
+    }
+
+    if (fields.isEmpty()) {
+      error = QObject::tr("Not a binary log file");
+      return false;
+    }
+
+    uchar type = buffer[pos];
+    int valueSize = (type == BINARYLOG_KEYFRAME ? 4 : 2);
+    if (type != BINARYLOG_KEYFRAME && type != BINARYLOG_DELTA) {
+      error = QObject::tr("Invalid record at offset %1").arg(pos);
+      return false;
+    }
+    if (pos + 1 + fields.count()*valueSize > size) {
+      // last record truncated
+      break;
+    }
+    pos += 1;
+    for (int i=0; i<fields.count(); i++, pos+=valueSize) {
+      if (type == BINARYLOG_KEYFRAME)
+        values[i] = qFromLittleEndian<qint32>(buffer+pos);
+      else
+        values[i] += qFromLittleEndian<qint16>(buffer+pos);
+    }
+
+    QStringList row;
+    qint32 latitude = 0;
+    for (int i=0; i<fields.count(); i++) {
+      const BinaryLogField & field = fields.at(i);
+      if (field.kind == BINARYLOG_FIELD_TIME) {
+        if (!started) {
+          startTicks = values[i];
+          started = true;
+        }
+        QDateTime time = startTime.addMSecs(qint64(values[i] - startTicks) * 10);
+        row << time.toString("yyyy-MM-dd") << time.toString("HH:mm:ss.zzz");
+        continue;
+      }
+      while (row.count() <= field.column) {
+        row << "";
+      }
+      switch (field.kind) {
+        case BINARYLOG_FIELD_LATITUDE:
+          latitude = values[i];
+          break;
+        case BINARYLOG_FIELD_LONGITUDE:
+          if (latitude || values[i])
+            row[field.column] = formatGpsCoordinate(values[i], 'E', 'W') + " " + formatGpsCoordinate(latitude, 'N', 'S');
+          break;
+        case BINARYLOG_FIELD_SENSOR:
+          row[field.column] = formatValue(values[i], field.prec);
+          break;
+        default:
+          row[field.column] = QString::number(values[i]);
+          break;
+      }
+    }
+    rows.append(row);
+  }
+
+  // all rows have the same number of columns as the header
+  for (int i=0; i<rows.count(); i++) {
+    while (rows[i].count() < header.count()) {
+      rows[i] << "";
+    }
+  }
+  rows.prepend(header);
+  return true;
+}
+
+bool writeCsvLog(const QString & fileName, const QList<QStringList> & rows)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+    return false;
+  }
+  QTextStream stream(&file);
+  foreach (const QStringList & row, rows) {
+    stream << row.join(",") << "\n";
+  }
+  return true;
+}
@@ -0,0 +1,35 @@
+#ifndef _BINARYLOG_H_
+#define _BINARYLOG_H_
+
+#include <QtCore>
+
+/*
+ * Reader for the binary logs (.otl files) written by the radio.
+ *
+ * Each session starts with a header and the description of its fields, followed
+ * by fixed size records: keyframes (int32 values) or deltas from the previous record
+ * (int16 values). The records are converted to the same rows as the CSV logs,
+ * the first row being the header "Date,Time,<fields>".
+ */
+
+#define BINARYLOG_MAGIC            "OTXL"
+#define BINARYLOG_VERSION          1
+#define BINARYLOG_HEADER_SIZE      12
+#define BINARYLOG_FIELD_SIZE       16
+#define BINARYLOG_KEYFRAME         'K'
+#define BINARYLOG_DELTA            'D'
+
+enum BinaryLogFieldKind {
+  BINARYLOG_FIELD_TIME,
+  BINARYLOG_FIELD_SENSOR,
+  BINARYLOG_FIELD_LATITUDE,
+  BINARYLOG_FIELD_LONGITUDE,
+  BINARYLOG_FIELD_STICK,
+  BINARYLOG_FIELD_SWITCH
+};
+
+bool isBinaryLog(const QString & fileName);
+bool readBinaryLog(const QString & fileName, QList<QStringList> & rows, QString & error);
+bool writeCsvLog(const QString & fileName, const QList<QStringList> & rows);
+
+#endif // _BINARYLOG_H_
@@ -98,6 +98,8 @@ void SensorData::updateUnit()
   if (type == TELEM_TYPE_CALCULATED) {
     if (formula == TELEM_FORMULA_CONSUMPTION)
       unit = UNIT_MAH;
+    else if (formula == TELEM_FORMULA_BEARING)
+      unit = UNIT_DEGREE;
   }
 }
 
@@ -903,7 +903,8 @@ class SensorData {
       TELEM_FORMULA_CELL,
       TELEM_FORMULA_CONSUMPTION,
       TELEM_FORMULA_DIST,
-      TELEM_FORMULA_LAST = TELEM_FORMULA_DIST
+      TELEM_FORMULA_BEARING,
+      TELEM_FORMULA_LAST = TELEM_FORMULA_BEARING
     };
 
     enum {
@@ -974,6 +975,7 @@ class SensorData {
     bool logs;
     bool persistent;
     bool onlyPositive;
+    bool history;
 
     // for custom sensors
     unsigned int ratio;
@@ -2137,6 +2137,10 @@ class ArmCustomFunctionField: public TransformedField {
           else
             *((uint32_t *)_param) = value;
         }
+        else if (fn.func == FuncLogs && version >= 216) {
+          *((uint16_t *)_param) = fn.param;
+          *((uint8_t *)(_param+2)) = fn.adjustMode;
+        }
         else if (fn.func == FuncReset) {
           if (version >= 217)
             *((uint32_t *)_param) = fn.param;
@@ -2186,6 +2190,10 @@ class ArmCustomFunctionField: public TransformedField {
       else if (fn.func == FuncVolume) {
         sourcesConversionTable->importValue(value, (int &)fn.param);
       }
+      else if (fn.func == FuncLogs && version >= 216) {
+        fn.param = value;
+        fn.adjustMode = mode;
+      }
       else if (fn.func >= FuncAdjustGV1 && fn.func <= FuncAdjustGVLast) {
         if (version >= 216) {
           fn.func = AssignFunc(fn.func + index);
@@ -2805,7 +2813,8 @@ class SensorField: public TransformedField {
       internalField.Append(new BoolField<1>(sensor.logs));
       internalField.Append(new BoolField<1>(sensor.persistent));
       internalField.Append(new BoolField<1>(sensor.onlyPositive));
-      internalField.Append(new SpareBitsField<3>());
+      internalField.Append(new BoolField<1>(sensor.history));
+      internalField.Append(new SpareBitsField<2>());
       internalField.Append(new UnsignedField<32>(_param, "param"));
     }
 
@@ -2824,7 +2833,7 @@ class SensorField: public TransformedField {
           _param = (sensor.source) + (sensor.index << 8);
         else if (sensor.formula == SensorData::TELEM_FORMULA_ADD || sensor.formula == SensorData::TELEM_FORMULA_MULTIPLY || sensor.formula == SensorData::TELEM_FORMULA_MIN || sensor.formula == SensorData::TELEM_FORMULA_MAX)
           _param = ((uint8_t)sensor.sources[0]) + ((uint8_t)sensor.sources[1] << 8) + ((uint8_t)sensor.sources[2] << 16) + ((uint8_t)sensor.sources[3] << 24);
-        else if (sensor.formula == SensorData::TELEM_FORMULA_DIST)
+        else if (sensor.formula == SensorData::TELEM_FORMULA_DIST || sensor.formula == SensorData::TELEM_FORMULA_BEARING)
           _param = (sensor.gps) + (sensor.alt << 8);
         else if (sensor.formula == SensorData::TELEM_FORMULA_CONSUMPTION || sensor.formula == SensorData::TELEM_FORMULA_TOTALIZE)
           _param = (sensor.amps);
@@ -2847,7 +2856,7 @@ class SensorField: public TransformedField {
         else if (sensor.formula == SensorData::TELEM_FORMULA_ADD || sensor.formula == SensorData::TELEM_FORMULA_MULTIPLY || sensor.formula == SensorData::TELEM_FORMULA_MIN || sensor.formula == SensorData::TELEM_FORMULA_MAX)
           for (int i=0; i<4; ++i)
             sensor.sources[i] = _sources[i];
-        else if (sensor.formula == SensorData::TELEM_FORMULA_DIST)
+        else if (sensor.formula == SensorData::TELEM_FORMULA_DIST || sensor.formula == SensorData::TELEM_FORMULA_BEARING)
           (sensor.gps = _sources[0], sensor.alt = _sources[1]);
         else if (sensor.formula == SensorData::TELEM_FORMULA_CONSUMPTION || sensor.formula == SensorData::TELEM_FORMULA_TOTALIZE)
           sensor.amps = _sources[0];
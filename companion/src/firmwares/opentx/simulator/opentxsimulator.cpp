@@ -20,6 +20,10 @@
 #include <exception>
 #include <map>
 #include <string>
+#include <chrono>
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
 
 #define COMPANION
 #define SIMU
@@ -75,6 +79,10 @@
   #define MIXERS_MONITOR
 #endif
 
+#if defined(CPUARM)
+  #define MIXER_PROFILER
+#endif
+
 #undef min
 #undef max
 
@@ -87,6 +95,7 @@ namespace NAMESPACE {
 #include "radio/src/main_arm.cpp"
 #include "radio/src/pulses/pulses_arm.cpp"
 #include "radio/src/tasks_arm.cpp"
+#include "radio/src/profiler.cpp"
 #include "radio/src/audio_arm.cpp"
 #include "radio/src/telemetry/telemetry.cpp"
 #include "radio/src/telemetry/frsky_sport.cpp"
@@ -496,6 +505,21 @@ void OpenTxSimulator::sendTelemetry(::uint8_t * data, unsigned int len)
 #endif
 }
 
+unsigned int OpenTxSimulator::sendTelemetryStream(const ::uint8_t * data, unsigned int len)
+{
+#if defined(PCBTARANIS)
+  // same path as the telemetry driver, the bytes are decoded by telemetryWakeup()
+  // the replay is throttled by the free space, a full fifo is not a radio overflow
+  unsigned int count = std::min<unsigned int>(len, telemetryFifo.freeSpace());
+  return telemetryFifo.push(data, count);
+#else
+  for (unsigned int i=0; i<len; i++) {
+    processSerialData(data[i]);
+  }
+  return len;
+#endif
+}
+
 void OpenTxSimulator::setTrainerInput(unsigned int inputNumber, ::int16_t value)
 {
 #define SETTRAINER_IMPORT
@@ -507,6 +531,33 @@ void OpenTxSimulator::installTraceHook(void (*callback)(const char *))
   traceCallback = callback;
 }
 
+#if defined(CPUARM)
+void (*profilerCallback)(const char *) = NULL;
+
+void profilerOutput(const char * line)
+{
+  std::string text(line);
+  text += "\n";
+  profilerCallback(text.c_str());
+}
+#endif
+
+void OpenTxSimulator::dumpMixerProfiler(void (*callback)(const char *))
+{
+#if defined(MIXER_PROFILER)
+  profilerCallback = callback;
+  mixerProfilerDump(profilerOutput);
+#endif
+}
+
+void OpenTxSimulator::dumpAudioStats(void (*callback)(const char *))
+{
+#if defined(CPUARM)
+  profilerCallback = callback;
+  audioQueue.dumpStats(profilerOutput);
+#endif
+}
+
 class OpenTxSimulatorFactory: public SimulatorFactory
 {
   public:
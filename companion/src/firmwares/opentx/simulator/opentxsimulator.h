@@ -122,9 +122,15 @@ class DLLEXPORT OpenTxSimulator : public SimulatorInterface {
 
     virtual void sendTelemetry(uint8_t * data, unsigned int len);
 
+    virtual unsigned int sendTelemetryStream(const uint8_t * data, unsigned int len);
+
     virtual void setTrainerInput(unsigned int inputNumber, int16_t value);
 
     virtual void installTraceHook(void (*callback)(const char *));
+
+    virtual void dumpMixerProfiler(void (*callback)(const char *));
+
+    virtual void dumpAudioStats(void (*callback)(const char *));
 };
 
 }
@@ -2,6 +2,7 @@
 #include "appdata.h"
 #include "ui_logsdialog.h"
 #include "helpers.h"
+#include "binarylog.h"
 #if defined WIN32 || !defined __GNUC__
 #include <windows.h>
 #else
@@ -518,7 +519,19 @@ bool LogsDialog::cvsFileParse()
   int errors=0;
   int lines=-1;
 
-  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) { // reading HEX TEXT file
+  ui->exportCsv_BT->setEnabled(false);
+
+  if (isBinaryLog(file.fileName())) {
+    QString error;
+    if (!readBinaryLog(file.fileName(), csvlog, error)) {
+      QMessageBox::warning(this, "Companion", error);
+      csvlog.clear();
+      return false;
+    }
+    logFilename = QFileInfo(file.fileName()).baseName();
+    ui->exportCsv_BT->setEnabled(true);
+  }
+  else if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) { // reading HEX TEXT file
     return false;
   }
   else {
@@ -571,6 +584,14 @@ bool LogsDialog::cvsFileParse()
   return true;
 }
 
+void LogsDialog::on_exportCsv_BT_clicked()
+{
+  QString fileName = QFileDialog::getSaveFileName(this, tr("Export to CSV"), QFileInfo(ui->FileName_LE->text()).absolutePath() + "/" + logFilename + ".csv", tr("CSV files (*.csv)"));
+  if (!fileName.isEmpty() && !writeCsvLog(fileName, csvlog)) {
+    QMessageBox::warning(this, "Companion", tr("Cannot write file %1").arg(fileName));
+  }
+}
+
 struct FlightSession {
   QDateTime start;
   QDateTime end;
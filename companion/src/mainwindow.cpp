@@ -67,6 +67,7 @@
 #include "appdata.h"
 #include "radionotfound.h"
 #include "process_sync.h"
+#include "process_soundpack.h"
 #include "radiointerface.h"
 #include "progressdialog.h"
 
@@ -682,6 +683,27 @@ void MainWindow::sdsync()
   }
 }
 
+void MainWindow::compressSoundPack()
+{
+  QString source = QFileDialog::getExistingDirectory(this, tr("Select the sound pack folder"), g.profile[g.id()].sdPath());
+  if (source.isEmpty()) {
+    return;
+  }
+  QString destination = QFileDialog::getExistingDirectory(this, tr("Select the compressed sound pack folder"), source);
+  if (destination.isEmpty()) {
+    return;
+  }
+  if (QDir(source) == QDir(destination)) {
+    QMessageBox::warning(this, QObject::tr("Sound pack error"), QObject::tr("The compressed sound pack must be written in another folder!"));
+    return;
+  }
+  ProgressDialog progressDialog(this, tr("Compress Sound Pack"), CompanionIcon("sdsync.png"));
+  SoundPackProcess soundPackProcess(source, destination, progressDialog.progress());
+  if (!soundPackProcess.run()) {
+    progressDialog.exec();
+  }
+}
+
 void MainWindow::changelog()
 {
   ReleaseNotesDialog * dialog = new ReleaseNotesDialog(this);
@@ -1069,6 +1091,7 @@ void MainWindow::createActions()
     readBackupToFileAct = addAct("read_eeprom_file.png", tr("Backup Radio to File"), tr("Save a complete backup file of all settings and model data in the Radio"), SLOT(readBackup()));
     contributorsAct =    addAct("contributors.png",  tr("Contributors..."), tr("A tribute to those who have contributed to OpenTX and Companion"), SLOT(contributors()));
     sdsyncAct =          addAct("sdsync.png",        tr("Synchronize SD"),          tr("SD card synchronization"),            SLOT(sdsync()));
+    soundPackAct =       addAct("",                  tr("Compress Sound Pack..."),  tr("Convert the sound files to IMA-ADPCM to save SD card space and bandwidth"), SLOT(compressSoundPack()));
 
     compareAct->setEnabled(false);
     simulateAct->setEnabled(false);
@@ -1099,6 +1122,7 @@ void MainWindow::createMenus()
     fileMenu->addAction(printAct);
     fileMenu->addAction(compareAct);
     fileMenu->addAction(sdsyncAct);
+    fileMenu->addAction(soundPackAct);
     fileMenu->addSeparator();
     fileMenu->addAction(exitAct);
 
@@ -148,6 +148,7 @@ class MainWindow : public QMainWindow
     void simulate();
     void contributors();
     void sdsync();
+    void compressSoundPack();
     void changelog();
     void fwchangelog();
     void customizeSplash();
@@ -228,6 +229,7 @@ class MainWindow : public QMainWindow
     QAction *checkForUpdatesAct;
     QAction *contributorsAct;
     QAction *sdsyncAct;
+    QAction *soundPackAct;
     QAction *changelogAct;
     QAction *fwchangelogAct;
     QAction *compareAct;
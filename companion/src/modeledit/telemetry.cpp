@@ -504,6 +504,7 @@ TelemetrySensorPanel::TelemetrySensorPanel(QWidget *parent, SensorData & sensor,
   ui->logs->setField(sensor.logs);
   ui->persistent->setField(sensor.persistent);
   ui->onlyPositive->setField(sensor.onlyPositive);
+  ui->history->setField(sensor.history);
   ui->gpsSensor->setField(sensor.gps);
   ui->altSensor->setField(sensor.alt);
   ui->ampsSensor->setField(sensor.amps);
@@ -552,7 +553,7 @@ void TelemetrySensorPanel::update()
     ui->formula->show();
     ui->formula->setCurrentIndex(sensor.formula);
     isConfigurable = (sensor.formula < SensorData::TELEM_FORMULA_CELL);
-    gpsFieldsDisplayed = (sensor.formula == SensorData::TELEM_FORMULA_DIST);
+    gpsFieldsDisplayed = (sensor.formula == SensorData::TELEM_FORMULA_DIST || sensor.formula == SensorData::TELEM_FORMULA_BEARING);
     cellsFieldsDisplayed = (sensor.formula == SensorData::TELEM_FORMULA_CELL);
     consFieldsDisplayed = (sensor.formula == SensorData::TELEM_FORMULA_CONSUMPTION);
     sources12FieldsDisplayed = (sensor.formula <= SensorData::TELEM_FORMULA_MULTIPLY);
@@ -602,8 +603,8 @@ void TelemetrySensorPanel::update()
   ui->unit->setVisible((sensor.type == SensorData::TELEM_TYPE_CALCULATED && (sensor.formula == SensorData::TELEM_FORMULA_DIST)) || isConfigurable);
   ui->gpsSensorLabel->setVisible(gpsFieldsDisplayed);
   ui->gpsSensor->setVisible(gpsFieldsDisplayed);
-  ui->altSensorLabel->setVisible(gpsFieldsDisplayed);
-  ui->altSensor->setVisible(gpsFieldsDisplayed);
+  ui->altSensorLabel->setVisible(gpsFieldsDisplayed && sensor.formula == SensorData::TELEM_FORMULA_DIST);
+  ui->altSensor->setVisible(gpsFieldsDisplayed && sensor.formula == SensorData::TELEM_FORMULA_DIST);
   ui->ampsSensorLabel->setVisible(consFieldsDisplayed || totalizeFieldsDisplayed);
   ui->ampsSensor->setVisible(consFieldsDisplayed || totalizeFieldsDisplayed);
   ui->cellsSensorLabel->setVisible(cellsFieldsDisplayed);
@@ -675,6 +676,10 @@ void TelemetrySensorPanel::on_formula_currentIndexChanged(int index)
       sensor.prec = 0;
       sensor.unit = SensorData::UNIT_METERS;
     }
+    else if (sensor.formula == SensorData::TELEM_FORMULA_BEARING) {
+      sensor.prec = 0;
+      sensor.unit = SensorData::UNIT_DEGREE;
+    }
     emit dataModified();
     emit modified();
   }
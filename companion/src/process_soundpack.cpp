@@ -0,0 +1,265 @@
+#include "process_soundpack.h"
+#include "progresswidget.h"
+#include <QDirIterator>
+#include <QMessageBox>
+#include <QEventLoop>
+#include <QTimer>
+#include <QtEndian>
+#include <math.h>
+
+#define WAV_FORMAT_PCM        1
+#define WAV_FORMAT_IMA_ADPCM  0x11
+#define ADPCM_BLOCK_SIZE      256
+#define ADPCM_BLOCK_SAMPLES   ((ADPCM_BLOCK_SIZE-4)*2+1)
+#define RESAMPLE_TAPS         16     // sinc lobes on each side of the output sample
+
+static const int adpcmIndexes[16] = { -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8 };
+static const int adpcmSteps[89] = { 7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767 };
+
+SoundPackProcess::SoundPackProcess(const QString & source, const QString & destination, ProgressWidget * progress, int sampleRate):
+  source(source),
+  destination(destination),
+  progress(progress),
+  sampleRate(sampleRate),
+  index(0),
+  count(0),
+  closed(false)
+{
+  connect(progress, SIGNAL(stopped()),this, SLOT(onClosed()));
+}
+
+void SoundPackProcess::onClosed()
+{
+  closed = true;
+}
+
+bool SoundPackProcess::run()
+{
+  if (!QFile::exists(source)) {
+    QMessageBox::warning(NULL, QObject::tr("Sound pack error"), QObject::tr("The directory '%1' doesn't exist!").arg(source));
+    return true;
+  }
+
+  if (!QFile::exists(destination)) {
+    QMessageBox::warning(NULL, QObject::tr("Sound pack error"), QObject::tr("The directory '%1' doesn't exist!").arg(destination));
+    return true;
+  }
+
+  count = getFilesCount(source);
+  progress->setMaximum(count);
+
+  QDir sourceDir(source), destinationDir(destination);
+  QDirIterator it(source, QDirIterator::Subdirectories);
+  while (!closed && it.hasNext()) {
+    QEventLoop loop;
+    QTimer::singleShot(10, &loop, SLOT(quit()));
+    loop.exec();
+    index++;
+    progress->setInfo(tr("%1/%2 files").arg(index).arg(count));
+    progress->setValue(index);
+    QString result = convertEntry(it.next(), sourceDir, destinationDir);
+    if (!result.isEmpty()) {
+      errors << result;
+    }
+  }
+
+  if (errors.count() > 0) {
+    QMessageBox::warning(NULL, QObject::tr("Sound pack error"), errors.join("\n"));
+  }
+
+  // don't close the window unless the user wanted
+  return closed;
+}
+
+int SoundPackProcess::getFilesCount(const QString & directory)
+{
+  int result = 0;
+  QDirIterator it(directory, QDirIterator::Subdirectories);
+  while (it.hasNext()) {
+    it.next();
+    result++;
+  }
+  return result;
+}
+
+QString SoundPackProcess::convertEntry(const QString & path, const QDir & source, const QDir & destination)
+{
+  QFileInfo sourceInfo(path);
+  QString relativePath = source.relativeFilePath(path);
+  QString destinationPath = destination.absoluteFilePath(relativePath);
+
+  if (sourceInfo.isDir()) {
+    if (!QFileInfo(destinationPath).exists() && !destination.mkpath(relativePath)) {
+      return QObject::tr("Create '%1' failed").arg(destinationPath);
+    }
+    return QString();
+  }
+
+  QFile sourceFile(path);
+  if (!sourceFile.open(QFile::ReadOnly)) {
+    return QObject::tr("Open '%1' failed").arg(path);
+  }
+  QByteArray contents = sourceFile.readAll();
+  sourceFile.close();
+
+  // the other files, and the wav which can't be converted, are copied as they are
+  QVector<int16_t> samples;
+  int rate;
+  if (sourceInfo.suffix().toLower() == "wav" && readWav(contents, samples, rate)) {
+    progress->addText(tr("Convert %1\n").arg(relativePath));
+    contents = encodeAdpcm(resample(samples, rate, sampleRate), sampleRate);
+  }
+  else {
+    progress->addText(tr("Copy %1\n").arg(relativePath));
+  }
+
+  QFile destinationFile(destinationPath);
+  if (!destinationFile.open(QFile::WriteOnly) || destinationFile.write(contents) != contents.size()) {
+    return QObject::tr("Write '%1' failed").arg(destinationPath);
+  }
+  destinationFile.close();
+  return QString();
+}
+
+// PCM 8 and 16 bits files, the channels are mixed
+bool SoundPackProcess::readWav(const QByteArray & data, QVector<int16_t> & samples, int & rate)
+{
+  const uchar * buffer = (const uchar *)data.constData();
+  if (data.size() < 12 || memcmp(buffer, "RIFF", 4) || memcmp(buffer+8, "WAVE", 4)) {
+    return false;
+  }
+
+  int channels = 0, bits = 0, format = 0;
+  int pos = 12;
+  while (pos + 8 <= data.size()) {
+    const uchar * chunk = buffer + pos;
+    int size = qFromLittleEndian<quint32>(chunk + 4);
+    if (size < 0 || pos + 8 + size > data.size()) {
+      size = data.size() - pos - 8;
+    }
+    if (!memcmp(chunk, "fmt ", 4) && size >= 16) {
+      format = qFromLittleEndian<quint16>(chunk + 8);
+      channels = qFromLittleEndian<quint16>(chunk + 10);
+      rate = qFromLittleEndian<quint32>(chunk + 12);
+      bits = qFromLittleEndian<quint16>(chunk + 22);
+    }
+    else if (!memcmp(chunk, "data", 4)) {
+      if (format != WAV_FORMAT_PCM || channels == 0 || rate == 0 || (bits != 8 && bits != 16)) {
+        return false;
+      }
+      int frameSize = channels * bits / 8;
+      int frames = size / frameSize;
+      samples.resize(frames);
+      for (int i=0; i<frames; i++) {
+        int value = 0;
+        for (int j=0; j<channels; j++) {
+          const uchar * sample = chunk + 8 + i*frameSize + j*bits/8;
+          value += (bits == 8 ? (*sample - 128) << 8 : qFromLittleEndian<qint16>(sample));
+        }
+        samples[i] = value / channels;
+      }
+      return true;
+    }
+    pos += 8 + size + (size & 1);
+  }
+  return false;
+}
+
+// windowed sinc interpolation, the rates don't need to be multiples
+QVector<int16_t> SoundPackProcess::resample(const QVector<int16_t> & samples, int from, int to)
+{
+  if (from == to) {
+    return samples;
+  }
+
+  double ratio = double(from) / to;
+  double cutoff = qMin(1.0, 1.0 / ratio);   // the low pass filter is at the lowest Nyquist frequency
+  double width = RESAMPLE_TAPS / cutoff;
+  int count = qint64(samples.size()) * to / from;
+  QVector<int16_t> result(count);
+  for (int i=0; i<count; i++) {
+    double center = i * ratio;
+    int first = qMax(0, int(ceil(center - width)));
+    int last = qMin(samples.size()-1, int(floor(center + width)));
+    double value = 0, sum = 0;
+    for (int j=first; j<=last; j++) {
+      double x = j - center;
+      double window = 0.5 + 0.5 * cos(M_PI * x / width);
+      double sinc = (x == 0 ? 1.0 : sin(M_PI * x * cutoff) / (M_PI * x * cutoff));
+      value += samples[j] * sinc * window;
+      sum += sinc * window;
+    }
+    result[i] = qBound(-32768, int(lround(sum != 0 ? value / sum : 0)), 32767);
+  }
+  return result;
+}
+
+// mono IMA-ADPCM, as decoded by decodeAdpcm() in the radio audio task
+QByteArray SoundPackProcess::encodeAdpcm(const QVector<int16_t> & samples, int rate)
+{
+  QByteArray data;
+  int predictor = 0, stepIndex = 0;
+  int i = 0;
+  while (i < samples.size()) {
+    predictor = samples[i++];
+    data.append(char(predictor & 0xFF));
+    data.append(char((predictor >> 8) & 0xFF));
+    data.append(char(stepIndex));
+    data.append(char(0));
+    for (int j=0; j<ADPCM_BLOCK_SAMPLES-1 && i<samples.size(); j++, i++) {
+      int step = adpcmSteps[stepIndex];
+      int delta = samples[i] - predictor;
+      int nibble = 0, diff = step >> 3;
+      if (delta < 0) {
+        nibble = 8;
+        delta = -delta;
+      }
+      if (delta >= step) {
+        nibble |= 4;
+        delta -= step;
+        diff += step;
+      }
+      if (delta >= step / 2) {
+        nibble |= 2;
+        delta -= step / 2;
+        diff += step >> 1;
+      }
+      if (delta >= step / 4) {
+        nibble |= 1;
+        diff += step >> 2;
+      }
+      predictor = qBound(-32768, (nibble & 8) ? predictor - diff : predictor + diff, 32767);
+      stepIndex = qBound(0, stepIndex + adpcmIndexes[nibble], 88);
+      if (j & 1)
+        data[data.size()-1] = data[data.size()-1] | char(nibble << 4);
+      else
+        data.append(char(nibble));
+    }
+  }
+
+  QByteArray result;
+  uchar header[60];
+  memcpy(header, "RIFF", 4);
+  qToLittleEndian<quint32>(52 + data.size() + (data.size() & 1), header + 4);
+  memcpy(header + 8, "WAVEfmt ", 8);
+  qToLittleEndian<quint32>(20, header + 16);
+  qToLittleEndian<quint16>(WAV_FORMAT_IMA_ADPCM, header + 20);
+  qToLittleEndian<quint16>(1, header + 22);
+  qToLittleEndian<quint32>(rate, header + 24);
+  qToLittleEndian<quint32>(rate * ADPCM_BLOCK_SIZE / ADPCM_BLOCK_SAMPLES, header + 28);
+  qToLittleEndian<quint16>(ADPCM_BLOCK_SIZE, header + 32);
+  qToLittleEndian<quint16>(4, header + 34);
+  qToLittleEndian<quint16>(2, header + 36);
+  qToLittleEndian<quint16>(ADPCM_BLOCK_SAMPLES, header + 38);
+  memcpy(header + 40, "fact", 4);
+  qToLittleEndian<quint32>(4, header + 44);
+  qToLittleEndian<quint32>(samples.size(), header + 48);
+  memcpy(header + 52, "data", 4);
+  qToLittleEndian<quint32>(data.size(), header + 56);
+  result.append((const char *)header, sizeof(header));
+  result.append(data);
+  if (data.size() & 1) {
+    result.append(char(0));
+  }
+  return result;
+}
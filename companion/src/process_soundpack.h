@@ -0,0 +1,40 @@
+#ifndef SOUNDPACKPROCESS_H_
+#define SOUNDPACKPROCESS_H_
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <stdint.h>
+
+class QDir;
+class ProgressWidget;
+
+// Transcodes a sound pack to mono IMA-ADPCM, at a rate which the radio plays without resampling artifacts
+class SoundPackProcess : public QObject
+{
+    Q_OBJECT
+
+  public:
+    SoundPackProcess(const QString & source, const QString & destination, ProgressWidget * progress, int sampleRate=16000);
+    bool run();
+
+  protected slots:
+    void onClosed();
+
+  protected:
+    int getFilesCount(const QString & directory);
+    QString convertEntry(const QString & path, const QDir & source, const QDir & destination);
+    bool readWav(const QByteArray & data, QVector<int16_t> & samples, int & rate);
+    QVector<int16_t> resample(const QVector<int16_t> & samples, int from, int to);
+    QByteArray encodeAdpcm(const QVector<int16_t> & samples, int rate);
+    QString source;
+    QString destination;
+    ProgressWidget * progress;
+    int sampleRate;
+    QStringList errors;
+    int index;
+    int count;
+    bool closed;
+};
+
+#endif /* SOUNDPACKPROCESS_H_ */
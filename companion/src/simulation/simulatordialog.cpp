@@ -67,6 +67,8 @@ SimulatorDialog::SimulatorDialog(QWidget * parent, SimulatorInterface *simulator
   new QShortcut(QKeySequence(Qt::Key_F4), this, SLOT(openTelemetrySimulator()));
   new QShortcut(QKeySequence(Qt::Key_F5), this, SLOT(openTrainerSimulator()));
   new QShortcut(QKeySequence(Qt::Key_F6), this, SLOT(openDebugOutput()));
+  new QShortcut(QKeySequence(Qt::Key_F7), this, SLOT(dumpMixerProfiler()));
+  new QShortcut(QKeySequence(Qt::Key_F8), this, SLOT(dumpAudioStats()));
   traceCallbackInstance = this;
 }
 
@@ -318,6 +320,18 @@ void SimulatorDialog::openDebugOutput()
   }
 }
 
+void SimulatorDialog::dumpMixerProfiler()
+{
+  simulator->dumpMixerProfiler(traceCb);
+  openDebugOutput();
+}
+
+void SimulatorDialog::dumpAudioStats()
+{
+  simulator->dumpAudioStats(traceCb);
+  openDebugOutput();
+}
+
 void SimulatorDialog::onDebugOutputClose()
 {
   DebugOut = 0;
@@ -150,6 +150,8 @@ class SimulatorDialog : public QDialog
     void openTelemetrySimulator();
     void openTrainerSimulator();
     void openDebugOutput();
+    void dumpMixerProfiler();
+    void dumpAudioStats();
     void onDebugOutputClose();
 
 #ifdef JOYSTICKS
@@ -99,9 +99,16 @@ class SimulatorInterface
 
     virtual void sendTelemetry(uint8_t * data, unsigned int len) = 0;
 
+    // raw bytes as received from the telemetry module, returns the count of bytes accepted
+    virtual unsigned int sendTelemetryStream(const uint8_t * data, unsigned int len) { return len; };
+
     virtual void setTrainerInput(unsigned int inputNumber, int16_t value) = 0;
 
     virtual void installTraceHook(void (*callback)(const char *)) = 0;
+
+    virtual void dumpMixerProfiler(void (*callback)(const char *)) { };
+
+    virtual void dumpAudioStats(void (*callback)(const char *)) { };
 };
 
 class SimulatorFactory {
@@ -1,24 +1,50 @@
 #include <stdint.h>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QMessageBox>
+#include <QtEndian>
 #include "telemetrysimu.h"
 #include "ui_telemetrysimu.h"
 #include "simulatorinterface.h"
 #include "radio/src/telemetry/frsky.h"
 
+#define REPLAY_PERIOD  10 // ms
+
 TelemetrySimulator::TelemetrySimulator(QWidget * parent, SimulatorInterface * simulator):
   QDialog(parent),
   ui(new Ui::TelemetrySimulator),
-  simulator(simulator)
+  simulator(simulator),
+  captureTime(0),
+  replayPos(0),
+  replayOffset(0),
+  replayTime(0),
+  replayRecordTime(0),
+  replayDuration(0),
+  replayRealTime(0),
+  replayBytes(0)
 {
   ui->setupUi(this);
 
+  ui->replaySpeed->addItem(tr("1x"), 1);
+  ui->replaySpeed->addItem(tr("2x"), 2);
+  ui->replaySpeed->addItem(tr("5x"), 5);
+  ui->replaySpeed->addItem(tr("10x"), 10);
+  ui->replaySpeed->addItem(tr("Max"), 0);
+  ui->replay->setEnabled(false);
+
   timer = new QTimer(this);
   connect(timer, SIGNAL(timeout()), this, SLOT(onTimerEvent()));
   timer->start(100);
+
+  replayTimer = new QTimer(this);
+  connect(replayTimer, SIGNAL(timeout()), this, SLOT(onReplayTimerEvent()));
 }
 
 TelemetrySimulator::~TelemetrySimulator()
 {
   timer->stop();
+  replayTimer->stop();
+  captureFile.close();
   delete ui;
 }
 
@@ -32,9 +58,179 @@ void TelemetrySimulator::onTimerEvent()
 void TelemetrySimulator::closeEvent(QCloseEvent *event)
 {
   ui->Simulate->setChecked(false);
+  ui->record->setChecked(false);
+  ui->replay->setChecked(false);
   event->accept();
 }
 
+void TelemetrySimulator::on_record_toggled(bool checked)
+{
+  if (!checked) {
+    captureFile.close();
+    return;
+  }
+
+  QString fileName = QFileDialog::getSaveFileName(this, tr("Record telemetry"), QString(), tr("Telemetry captures (*.otc)"));
+  if (!fileName.isEmpty()) {
+    captureFile.setFileName(fileName);
+    if (captureFile.open(QIODevice::WriteOnly)) {
+      char header[TELEMETRY_CAPTURE_HEADER_SIZE] = { 0, 0, 0, 0, TELEMETRY_CAPTURE_VERSION, TELEMETRY_CAPTURE_SPORT, 0, 0 };
+      memcpy(header, TELEMETRY_CAPTURE_MAGIC, 4);
+      captureFile.write(header, sizeof(header));
+      captureTimer.start();
+      captureTime = 0;
+      return;
+    }
+    QMessageBox::critical(this, tr("Error"), tr("Cannot write file %1:\n%2.").arg(fileName).arg(captureFile.errorString()));
+  }
+
+  ui->record->blockSignals(true);
+  ui->record->setChecked(false);
+  ui->record->blockSignals(false);
+}
+
+void TelemetrySimulator::writeCaptureRecord(const uint8_t * data, int count)
+{
+  // the delays are in 10ms ticks as on the radio, the remainder is kept for the next record
+  qint64 delay = (captureTimer.elapsed() - captureTime) / 10;
+  captureTime += delay * 10;
+
+  uchar header[TELEMETRY_CAPTURE_RECORD_HEADER];
+  while (delay > TELEMETRY_CAPTURE_MAX_DELAY) {
+    qToLittleEndian<quint16>(TELEMETRY_CAPTURE_MAX_DELAY, header);
+    header[2] = 0;
+    captureFile.write((const char *)header, sizeof(header));
+    delay -= TELEMETRY_CAPTURE_MAX_DELAY;
+  }
+
+  qToLittleEndian<quint16>(delay, header);
+  header[2] = count;
+  captureFile.write((const char *)header, sizeof(header));
+  captureFile.write((const char *)data, count);
+}
+
+bool TelemetrySimulator::loadCapture(const QString & fileName)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    QMessageBox::critical(this, tr("Error"), tr("Cannot read file %1:\n%2.").arg(fileName).arg(file.errorString()));
+    return false;
+  }
+
+  QByteArray data = file.readAll();
+  const uchar * buffer = (const uchar *)data.constData();
+  if (data.size() < TELEMETRY_CAPTURE_HEADER_SIZE || data.left(4) != TELEMETRY_CAPTURE_MAGIC || buffer[4] != TELEMETRY_CAPTURE_VERSION || buffer[5] != TELEMETRY_CAPTURE_SPORT) {
+    QMessageBox::critical(this, tr("Error"), tr("%1 is not a telemetry capture.").arg(fileName));
+    return false;
+  }
+
+  replayDuration = 0;
+  int pos = TELEMETRY_CAPTURE_HEADER_SIZE;
+  while (pos + TELEMETRY_CAPTURE_RECORD_HEADER <= data.size()) {
+    replayDuration += 10 * qFromLittleEndian<quint16>(buffer + pos);
+    pos += TELEMETRY_CAPTURE_RECORD_HEADER + buffer[pos + 2];
+  }
+
+  replayData = data;
+  return true;
+}
+
+void TelemetrySimulator::on_load_clicked()
+{
+  QString fileName = QFileDialog::getOpenFileName(this, tr("Replay telemetry"), QString(), tr("Telemetry captures (*.otc)"));
+  if (!fileName.isEmpty()) {
+    ui->replay->setChecked(false);
+    if (loadCapture(fileName)) {
+      ui->replay->setEnabled(true);
+      ui->replayStatus->setText(QFileInfo(fileName).fileName());
+    }
+  }
+}
+
+void TelemetrySimulator::on_replay_toggled(bool checked)
+{
+  if (checked) {
+    replayPos = TELEMETRY_CAPTURE_HEADER_SIZE;
+    replayOffset = 0;
+    replayTime = 0;
+    replayRecordTime = 0;
+    replayRealTime = 0;
+    replayBytes = 0;
+    if (replayPos + TELEMETRY_CAPTURE_RECORD_HEADER <= replayData.size()) {
+      replayRecordTime = 10 * qFromLittleEndian<quint16>((const uchar *)replayData.constData() + replayPos);
+    }
+    replayClock.start();
+    replayTimer->start(REPLAY_PERIOD);
+  }
+  else {
+    replayTimer->stop();
+  }
+}
+
+void TelemetrySimulator::stopReplay()
+{
+  ui->replay->setChecked(false);
+}
+
+void TelemetrySimulator::updateReplayStatus()
+{
+  QString status = tr("%1s / %2s, %3 bytes").arg(replayRecordTime / 1000.0, 0, 'f', 1).arg(replayDuration / 1000.0, 0, 'f', 1).arg(replayBytes);
+  if (replayRealTime > 0) {
+    status += tr(", %1 bytes/s").arg(replayBytes * 1000 / replayRealTime);
+  }
+  ui->replayStatus->setText(status);
+}
+
+void TelemetrySimulator::onReplayTimerEvent()
+{
+  // the records are sent when their time is reached, or as fast as the radio fifo accepts them at max speed
+  int speed = ui->replaySpeed->itemData(ui->replaySpeed->currentIndex()).toInt();
+  qint64 elapsed = replayClock.restart();
+  replayRealTime += elapsed;
+  replayTime += elapsed * speed;
+
+  const uchar * buffer = (const uchar *)replayData.constData();
+  int size = replayData.size();
+  bool finished = false;
+
+  while (true) {
+    if (replayPos + TELEMETRY_CAPTURE_RECORD_HEADER > size) {
+      finished = true;
+      break;
+    }
+    if (speed > 0 && replayRecordTime > replayTime) {
+      break;
+    }
+    int count = buffer[replayPos + 2];
+    if (replayPos + TELEMETRY_CAPTURE_RECORD_HEADER + count > size) {
+      finished = true; // truncated record
+      break;
+    }
+    const uint8_t * data = buffer + replayPos + TELEMETRY_CAPTURE_RECORD_HEADER;
+    unsigned int sent = simulator->sendTelemetryStream(data + replayOffset, count - replayOffset);
+    replayOffset += sent;
+    replayBytes += sent;
+    if (replayOffset < count) {
+      break; // the radio fifo is full, the rest is sent at the next timer event
+    }
+    replayPos += TELEMETRY_CAPTURE_RECORD_HEADER + count;
+    replayOffset = 0;
+    if (replayPos + TELEMETRY_CAPTURE_RECORD_HEADER <= size) {
+      replayRecordTime += 10 * qFromLittleEndian<quint16>(buffer + replayPos);
+    }
+  }
+
+  if (speed == 0) {
+    replayTime = replayRecordTime;
+  }
+
+  updateReplayStatus();
+
+  if (finished) {
+    stopReplay();
+  }
+}
+
 void setSportPacketCrc(uint8_t * packet)
 {
   short crc = 0;
@@ -49,6 +245,28 @@ void setSportPacketCrc(uint8_t * packet)
   //TRACE("crc set: %x", packet[FRSKY_SPORT_PACKET_SIZE-1]);
 }
 
+void TelemetrySimulator::sendTelemetryPacket(uint8_t * packet)
+{
+  simulator->sendTelemetry(packet, FRSKY_SPORT_PACKET_SIZE);
+
+  if (captureFile.isOpen()) {
+    // recorded as received from the module, with the start byte and the byte stuffing
+    uint8_t frame[1 + 2*FRSKY_SPORT_PACKET_SIZE];
+    int count = 0;
+    frame[count++] = START_STOP;
+    for (int i=0; i<FRSKY_SPORT_PACKET_SIZE; i++) {
+      if (packet[i] == START_STOP || packet[i] == BYTESTUFF) {
+        frame[count++] = BYTESTUFF;
+        frame[count++] = packet[i] ^ STUFF_MASK;
+      }
+      else {
+        frame[count++] = packet[i];
+      }
+    }
+    writeCaptureRecord(frame, count);
+  }
+}
+
 void generateSportPacket(uint8_t * packet, uint8_t dataId, uint8_t prim, uint16_t appId, uint32_t data)
 {
   packet[0] = dataId;
@@ -198,7 +416,7 @@ void TelemetrySimulator::generateTelemetryFrame()
   }
 
   if (ok && buffer[0])
-    simulator->sendTelemetry(buffer, FRSKY_SPORT_PACKET_SIZE);
+    sendTelemetryPacket(buffer);
   else
     onTimerEvent();
 }
@@ -5,6 +5,8 @@
 #include <QCloseEvent>
 #include <QDialog>
 #include <QTimer>
+#include <QFile>
+#include <QElapsedTimer>
 #include "simulatorinterface.h"
 
 #define INSTANCE (ui->Instance->text().toInt(&ok,0) -1)
@@ -32,9 +34,35 @@ class TelemetrySimulator : public QDialog
     SimulatorInterface *simulator;
 
     void generateTelemetryFrame();
+    void sendTelemetryPacket(uint8_t * packet);
+
+    // capture of the packets sent, in the same format as the radio SPORT_FILE_LOG files
+    QFile captureFile;
+    QElapsedTimer captureTimer;
+    qint64 captureTime;
+    void writeCaptureRecord(const uint8_t * data, int count);
+
+    // replay of a capture file
+    QTimer * replayTimer;
+    QElapsedTimer replayClock;
+    QByteArray replayData;
+    int replayPos;              // position of the next record
+    int replayOffset;           // bytes of the next record already sent
+    qint64 replayTime;          // replay time (ms)
+    qint64 replayRecordTime;    // time of the next record (ms)
+    qint64 replayDuration;      // (ms)
+    qint64 replayRealTime;      // time spent replaying (ms)
+    qint64 replayBytes;
+    bool loadCapture(const QString & fileName);
+    void stopReplay();
+    void updateReplayStatus();
 
   private slots:
     void onTimerEvent();
+    void on_record_toggled(bool checked);
+    void on_load_clicked();
+    void on_replay_toggled(bool checked);
+    void onReplayTimerEvent();
 
 };
 
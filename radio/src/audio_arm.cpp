@@ -36,10 +36,11 @@
 
 #include "opentx.h"
 #include <math.h>
+#include <stdio.h>
 
 extern OS_MutexID audioMutex;
 
-const int16_t sineValues[] =
+const int16_t sineValues[1024] =
 {
     0, 196, 392, 588, 784, 980, 1175, 1370, 1564, 1758,
     1951, 2143, 2335, 2525, 2715, 2904, 3091, 3278, 3463, 3647,
@@ -425,6 +426,8 @@ void referenceModelAudioFiles()
     }
     f_closedir(&dir);
   }
+
+  audioCache.requestWarmup();
 }
 
 bool isAudioFileReferenced(uint32_t i, char * filename)
@@ -509,6 +512,7 @@ void AudioQueue::start()
 #define CODEC_ID_PCM_S16LE  1
 #define CODEC_ID_PCM_ALAW   6
 #define CODEC_ID_PCM_MULAW  7
+#define CODEC_ID_ADPCM_IMA  0x11
 
 #ifndef SIMU
 void audioTask(void* pdata)
@@ -533,13 +537,42 @@ void audioTask(void* pdata)
 }
 #endif
 
-void mixSample(uint16_t * result, int sample, unsigned int fade)
+// the voices are rendered one by one in audioVoiceBuffer, then summed in audioMixBuffer
+int16_t audioMixBuffer[AUDIO_BUFFER_SIZE] __attribute__((aligned(16)));
+int16_t audioVoiceBuffer[AUDIO_BUFFER_SIZE] __attribute__((aligned(16)));
+
+// result[i] += samples[i], saturated
+void mixSamples(int16_t * result, const int16_t * samples, unsigned int count)
 {
+  unsigned int i = 0;
+
+#if defined(SIMU) && defined(__SSE2__)
+  for (; i+8<=count; i+=8) {
+    __m128i value = _mm_adds_epi16(_mm_loadu_si128((__m128i *)&result[i]), _mm_loadu_si128((__m128i *)&samples[i]));
+    _mm_storeu_si128((__m128i *)&result[i], value);
+  }
+#elif !defined(SIMU) && defined(__ARM_FEATURE_DSP)
+  // the buffers are word aligned, 2 samples per QADD16
+  for (; i+2<=count; i+=2) {
+    *(uint32_t *)&result[i] = __QADD16(*(uint32_t *)&result[i], *(const uint32_t *)&samples[i]);
+  }
+#endif
+
+  for (; i<count; i++) {
+    result[i] = limit<int>(-32768, result[i] + samples[i], 32767);
+  }
+}
+
+// the mixed samples are converted to the DAC format
+void convertSamples(uint16_t * result, const int16_t * samples, unsigned int count)
+{
+  for (unsigned int i=0; i<count; i++) {
 #if defined(SIMU_AUDIO)
-  *result = limit(0, *result + ((sample >> fade) ), 0xFFFF);
+    result[i] = samples[i] + 0x8000;
 #else
-  *result = limit(0, *result + ((sample >> fade) >> 4), 4095);
+    result[i] = (samples[i] >> 4) + (0x8000 >> 4);
 #endif
+  }
 }
 
 #if defined(SDCARD)
@@ -547,122 +580,490 @@ void mixSample(uint16_t * result, int sample, unsigned int fade)
 #define RIFF_CHUNK_SIZE 12
 uint8_t wavBuffer[AUDIO_BUFFER_SIZE*2];
 
-int WavContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
+FRESULT readWavHeader(FIL * file, WavHeader & header)
+{
+  UINT read;
+  FRESULT result = f_read(file, wavBuffer, RIFF_CHUNK_SIZE+8, &read);
+  if (result != FR_OK || read != RIFF_CHUNK_SIZE+8 || memcmp(wavBuffer, "RIFF", 4) || memcmp(wavBuffer+8, "WAVEfmt ", 8)) {
+    return FR_DENIED;
+  }
+
+  uint32_t size = *((uint32_t *)(wavBuffer+16));
+  result = (size < 256 ? f_read(file, wavBuffer, size+8, &read) : FR_DENIED);
+  if (result != FR_OK || read != size+8) {
+    return FR_DENIED;
+  }
+
+  header.codec = ((uint16_t *)wavBuffer)[0];
+  uint32_t freq = ((uint16_t *)wavBuffer)[2];
+  if (freq == 0 || freq * (AUDIO_SAMPLE_RATE / freq) != AUDIO_SAMPLE_RATE) {
+    return FR_DENIED;
+  }
+  header.resampleRatio = (AUDIO_SAMPLE_RATE / freq);
+
+  header.blockSize = 0;
+  if (header.codec == CODEC_ID_ADPCM_IMA) {
+    // mono, 4 bits samples, at least one byte of samples after the block header
+    header.blockSize = ((uint16_t *)wavBuffer)[6];
+    if (((uint16_t *)wavBuffer)[1] != 1 || ((uint16_t *)wavBuffer)[7] != 4 || header.blockSize <= 4) {
+      return FR_DENIED;
+    }
+  }
+
+  uint32_t * wavSamplesPtr = (uint32_t *)(wavBuffer + size);
+  size = wavSamplesPtr[1];
+  while (memcmp(wavSamplesPtr, "data", 4) != 0) {
+    result = f_lseek(file, f_tell(file)+size);
+    if (result != FR_OK) {
+      return result;
+    }
+    result = f_read(file, wavBuffer, 8, &read);
+    if (result != FR_OK || read != 8) {
+      return FR_DENIED;
+    }
+    wavSamplesPtr = (uint32_t *)wavBuffer;
+    size = wavSamplesPtr[1];
+  }
+
+  header.offset = f_tell(file);
+  header.size = size;
+  return FR_OK;
+}
+
+const int8_t adpcmIndexes[16] = { -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8 };
+const int16_t adpcmSteps[89] = { 7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767 };
+
+inline int16_t decodeAdpcmNibble(AdpcmState & state, uint8_t nibble)
+{
+  int step = adpcmSteps[state.index];
+  int diff = step >> 3;
+  if (nibble & 1) diff += step >> 2;
+  if (nibble & 2) diff += step >> 1;
+  if (nibble & 4) diff += step;
+  state.predictor = limit<int>(-32768, (nibble & 8) ? state.predictor - diff : state.predictor + diff, 32767);
+  state.index = limit<int>(0, state.index + adpcmIndexes[nibble], DIM(adpcmSteps)-1);
+  return state.predictor;
+}
+
+// the bytes to read for the next count samples: each block starts with a 4 bytes header
+// which gives a single sample, the predictor
+unsigned int getAdpcmReadSize(const AdpcmState & state, unsigned int count)
+{
+  unsigned int size = 0;
+  unsigned int pos = state.blockPos;
+  if (state.nibblePending && count > 0) {
+    count--;
+  }
+  while (count > 0) {
+    if (pos < 4) {
+      size += 4 - pos;
+      pos = 4;
+      count--;
+    }
+    else {
+      unsigned int bytes = min<unsigned int>((count+1) / 2, state.blockSize - pos);
+      size += bytes;
+      pos += bytes;
+      count -= min<unsigned int>(count, 2*bytes);
+    }
+    if (pos == state.blockSize) {
+      pos = 0;
+    }
+  }
+  return size;
+}
+
+// the blocks may be split between 2 reads, they start with the predictor and the step index.
+// At most count samples are written, size is given by getAdpcmReadSize(), and when the
+// last byte gives one sample too many, its high nibble is decoded on the next call
+unsigned int decodeAdpcm(AdpcmState & state, const uint8_t * data, unsigned int size, int16_t * samples, unsigned int count, unsigned int shift)
+{
+  int16_t * result = samples;
+  int16_t * end = samples + count;
+  if (state.nibblePending && result < end) {
+    *result++ = decodeAdpcmNibble(state, state.nibble) >> shift;
+    state.nibblePending = false;
+  }
+  for (unsigned int i=0; i<size; i++) {
+    uint8_t byte = data[i];
+    switch (state.blockPos) {
+      case 0:
+        state.predictor = byte;
+        break;
+      case 1:
+        state.predictor |= byte << 8;
+        break;
+      case 2:
+        state.index = min<uint8_t>(byte, DIM(adpcmSteps)-1);
+        break;
+      case 3:
+        *result++ = state.predictor >> shift;
+        break;
+      default:
+        *result++ = decodeAdpcmNibble(state, byte & 0x0F) >> shift;
+        if (result < end) {
+          *result++ = decodeAdpcmNibble(state, byte >> 4) >> shift;
+        }
+        else {
+          state.nibble = byte >> 4;
+          state.nibblePending = true;
+        }
+        break;
+    }
+    if (++state.blockPos == state.blockSize) {
+      state.blockPos = 0;
+    }
+  }
+  return result - samples;
+}
+
+AudioCache audioCache;
+
+// phases, switches and logical switches prompts, see isAudioFileReferenced()
+#define AUDIO_CACHE_WARMUP_END  (3*128)
+
+AudioCacheEntry * AudioCache::find(const char * path)
+{
+  for (int i=0; i<AUDIO_CACHE_ENTRIES; i++) {
+    AudioCacheEntry * entry = &entries[i];
+    if (entry->path[0] && !strcmp(entry->path, path)) {
+      entry->lastUsed = get_tmr10ms();
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+void AudioCache::releaseData(AudioCacheEntry * entry)
+{
+  // the samples are kept contiguous, the next ones are moved down
+  uint32_t end = entry->dataPos + entry->dataSize;
+  memmove(&data[entry->dataPos], &data[end], dataUsed - end);
+  for (int i=0; i<AUDIO_CACHE_ENTRIES; i++) {
+    if (entries[i].dataSize && entries[i].dataPos >= end) {
+      entries[i].dataPos -= entry->dataSize;
+    }
+  }
+  dataUsed -= entry->dataSize;
+  entry->dataPos = entry->dataSize = entry->loaded = 0;
+}
+
+// releases the samples of the least recently used entry, its header is kept
+bool AudioCache::releaseData(bool evict)
+{
+  AudioCacheEntry * lru = NULL;
+  if (evict) {
+    tmr10ms_t now = get_tmr10ms();
+    for (int i=0; i<AUDIO_CACHE_ENTRIES; i++) {
+      AudioCacheEntry * entry = &entries[i];
+      if (entry->dataSize && !audioQueue.isCacheEntryUsed(entry) && (!lru || now - entry->lastUsed > now - lru->lastUsed)) {
+        lru = entry;
+      }
+    }
+  }
+  if (lru) {
+    releaseData(lru);
+    return true;
+  }
+  return false;
+}
+
+AudioCacheEntry * AudioCache::getFreeEntry(bool evict)
+{
+  AudioCacheEntry * lru = NULL;
+  tmr10ms_t now = get_tmr10ms();
+  for (int i=0; i<AUDIO_CACHE_ENTRIES; i++) {
+    AudioCacheEntry * entry = &entries[i];
+    if (!entry->path[0]) {
+      return entry;
+    }
+    if (evict && !audioQueue.isCacheEntryUsed(entry) && (!lru || now - entry->lastUsed > now - lru->lastUsed)) {
+      lru = entry;
+    }
+  }
+  if (lru && lru->dataSize) {
+    releaseData(lru);
+  }
+  return lru;
+}
+
+void AudioCache::reserve(AudioCacheEntry * entry, bool evict)
+{
+  if (!entry->dataSize && entry->header.size <= AUDIO_CACHE_MAX_FILE_SIZE) {
+    uint32_t size = (entry->header.size + 3) & ~3;
+    while (AUDIO_CACHE_SIZE - dataUsed < size && releaseData(evict));
+    if (AUDIO_CACHE_SIZE - dataUsed >= size) {
+      entry->dataPos = dataUsed;
+      entry->dataSize = size;
+      entry->loaded = 0;
+      dataUsed += size;
+    }
+  }
+}
+
+AudioCacheEntry * AudioCache::add(const char * path, const WavHeader & header, bool evict)
+{
+  AudioCacheEntry * entry = getFreeEntry(evict);
+  if (entry) {
+    memset(entry, 0, sizeof(AudioCacheEntry));
+    strcpy(entry->path, path);
+    entry->header = header;
+    entry->lastUsed = get_tmr10ms();
+    reserve(entry, evict);
+  }
+  return entry;
+}
+
+void AudioCache::load(AudioCacheEntry * entry, uint32_t pos, const uint8_t * samples, uint32_t count)
+{
+  if (entry->dataSize && pos == entry->loaded && pos + count <= entry->header.size) {
+    memcpy(&data[entry->dataPos + pos], samples, count);
+    entry->loaded += count;
+  }
+}
+
+void AudioCache::preload(const char * path)
+{
+  static FIL file;
+  if (!find(path) && f_open(&file, path, FA_OPEN_EXISTING | FA_READ) == FR_OK) {
+    WavHeader header;
+    if (readWavHeader(&file, header) == FR_OK) {
+      // the warmup never evicts anything
+      AudioCacheEntry * entry = add(path, header, false);
+      UINT read;
+      if (entry && entry->dataSize && f_read(&file, &data[entry->dataPos], header.size, &read) == FR_OK && read == header.size) {
+        entry->loaded = header.size;
+      }
+    }
+    f_close(&file);
+  }
+}
+
+// called by the audio task when no file is played
+void AudioCache::wakeup()
+{
+  if (flushRequested) {
+    flushRequested = false;
+    for (int i=0; i<AUDIO_CACHE_ENTRIES; i++) {
+      AudioCacheEntry * entry = &entries[i];
+      if (entry->path[0] && !audioQueue.isCacheEntryUsed(entry)) {
+        if (entry->dataSize) {
+          releaseData(entry);
+        }
+        entry->path[0] = '\0';
+      }
+    }
+  }
+
+  // the model prompts are loaded one per call
+  char filename[AUDIO_FILENAME_MAXLEN+1];
+  while (warmupIndex < AUDIO_CACHE_WARMUP_END) {
+    unsigned int category = PHASE_AUDIO_CATEGORY + warmupIndex / 128;
+    unsigned int index = (warmupIndex % 128) / 2;
+    unsigned int event = warmupIndex % 2;
+    warmupIndex++;
+    if (category == PHASE_AUDIO_CATEGORY && index >= MAX_FLIGHT_MODES)
+      continue;
+    if (category == SWITCH_AUDIO_CATEGORY && event)
+      continue;
+    if (category == LOGICAL_SWITCH_AUDIO_CATEGORY && index >= NUM_LOGICAL_SWITCH)
+      continue;
+    if (isAudioFileReferenced((category << 24) + (index << 16) + event, filename)) {
+      preload(filename);
+      break;
+    }
+  }
+}
+
+bool AudioQueue::isCacheEntryUsed(const AudioCacheEntry * entry)
+{
+  return (normalContext.fragment.type == FRAGMENT_FILE && normalContext.wav.state.cache == entry) ||
+         (backgroundContext.fragment.type == FRAGMENT_FILE && backgroundContext.state.cache == entry);
+}
+
+int WavContext::renderBuffer(int16_t * samples, int volume, unsigned int fade)
 {
   FRESULT result = FR_OK;
   UINT read = 0;
 
   if (fragment.file[1]) {
-    result = f_open(&state.file, fragment.file, FA_OPEN_EXISTING | FA_READ);
-    fragment.file[1] = 0;
-    if (result == FR_OK) {
-      result = f_read(&state.file, wavBuffer, RIFF_CHUNK_SIZE+8, &read);
-      if (result == FR_OK && read == RIFF_CHUNK_SIZE+8 && !memcmp(wavBuffer, "RIFF", 4) && !memcmp(wavBuffer+8, "WAVEfmt ", 8)) {
-        uint32_t size = *((uint32_t *)(wavBuffer+16));
-        result = (size < 256 ? f_read(&state.file, wavBuffer, size+8, &read) : FR_DENIED);
-        if (result == FR_OK && read == size+8) {
-          state.codec = ((uint16_t *)wavBuffer)[0];
-          state.freq = ((uint16_t *)wavBuffer)[2];
-          uint32_t *wavSamplesPtr = (uint32_t *)(wavBuffer + size);
-          uint32_t size = wavSamplesPtr[1];
-          if (state.freq != 0 && state.freq * (AUDIO_SAMPLE_RATE / state.freq) == AUDIO_SAMPLE_RATE) {
-            state.resampleRatio = (AUDIO_SAMPLE_RATE / state.freq);
-            state.readSize = (state.codec == CODEC_ID_PCM_S16LE ? 2*AUDIO_BUFFER_SIZE : AUDIO_BUFFER_SIZE) / state.resampleRatio;
-          }
-          else {
-            result = FR_DENIED;
-          }
-          while (result == FR_OK && memcmp(wavSamplesPtr, "data", 4) != 0) {
-            result = f_lseek(&state.file, f_tell(&state.file)+size);
-            if (result == FR_OK) {
-              result = f_read(&state.file, wavBuffer, 8, &read);
-              if (read != 8) result = FR_DENIED;
-              wavSamplesPtr = (uint32_t *)wavBuffer;
-              size = wavSamplesPtr[1];
-            }
-          }
-          state.size = size;
+    AudioCacheEntry * entry = audioCache.find(fragment.file);
+    WavHeader header;
+    state.cached = (entry && entry->isComplete());
+    if (state.cached) {
+      audioCache.hits++;
+      header = entry->header;
+    }
+    else {
+      audioCache.misses++;
+      result = f_open(&state.file, fragment.file, FA_OPEN_EXISTING | FA_READ);
+      if (result == FR_OK) {
+        if (entry) {
+          // the header has already been parsed
+          header = entry->header;
+          result = f_lseek(&state.file, header.offset);
+          entry->loaded = 0;
+          audioCache.reserve(entry);
         }
         else {
-          result = FR_DENIED;
+          result = readWavHeader(&state.file, header);
+          if (result == FR_OK) {
+            entry = audioCache.add(fragment.file, header);
+          }
         }
       }
-      else {
-        result = FR_DENIED;
-      }
+    }
+    fragment.file[1] = 0;
+    state.cache = entry;
+    state.pos = 0;
+    if (result == FR_OK) {
+      state.codec = header.codec;
+      state.resampleRatio = header.resampleRatio;
+      if (state.codec == CODEC_ID_PCM_S16LE)
+        state.readSize = 2*AUDIO_BUFFER_SIZE / state.resampleRatio;
+      else if (state.codec == CODEC_ID_ADPCM_IMA)
+        state.readSize = 0; // depends on the position in the block, see below
+      else
+        state.readSize = AUDIO_BUFFER_SIZE / state.resampleRatio;
+      state.size = header.size;
+      state.adpcm.blockSize = header.blockSize;
+      state.adpcm.blockPos = 0;
+      state.adpcm.nibblePending = false;
     }
   }
 
   read = 0;
   if (result == FR_OK) {
-    result = f_read(&state.file, wavBuffer, state.readSize, &read);
+    const uint8_t * wavSamples = wavBuffer;
+    if (state.codec == CODEC_ID_ADPCM_IMA) {
+      // the whole buffer is filled, whatever the headers of the blocks read
+      state.readSize = getAdpcmReadSize(state.adpcm, AUDIO_BUFFER_SIZE / state.resampleRatio);
+    }
+    if (state.cached) {
+      wavSamples = audioCache.getData(state.cache) + state.pos;
+      read = min<uint32_t>(state.readSize, state.size);
+      state.cache->lastUsed = get_tmr10ms();
+    }
+    else {
+      result = f_read(&state.file, wavBuffer, state.readSize, &read);
+      if (result == FR_OK && state.cache) {
+        // the samples are loaded in the cache while played
+        audioCache.load(state.cache, state.pos, wavBuffer, min<uint32_t>(read, state.size));
+      }
+    }
     if (result == FR_OK) {
       if (read > state.size) {
         read = state.size;
       }
       state.size -= read;
+      state.pos += read;
 
       if (read != state.readSize) {
-        f_close(&state.file);
+        if (!state.cached) {
+          f_close(&state.file);
+        }
         fragment.clear();
       }
 
-      uint16_t * samples = buffer->data;
+      // decoded with the volume and fade applied, at the file rate
+      unsigned int shift = fade+2-volume;
       if (state.codec == CODEC_ID_PCM_S16LE) {
         read /= 2;
         for (uint32_t i=0; i<read; i++) {
-          for (uint8_t j=0; j<state.resampleRatio; j++) {
-            mixSample(samples++, ((int16_t *)wavBuffer)[i], fade+2-volume);
-          }
+          samples[i] = ((int16_t *)wavSamples)[i] >> shift;
         }
       }
       else if (state.codec == CODEC_ID_PCM_ALAW) {
         for (uint32_t i=0; i<read; i++) {
-          for (uint8_t j=0; j<state.resampleRatio; j++) {
-            mixSample(samples++, alawTable[wavBuffer[i]], fade+2-volume);
-          }
+          samples[i] = alawTable[wavSamples[i]] >> shift;
         }
       }
       else if (state.codec == CODEC_ID_PCM_MULAW) {
         for (uint32_t i=0; i<read; i++) {
-          for (uint8_t j=0; j<state.resampleRatio; j++) {
-            mixSample(samples++, ulawTable[wavBuffer[i]], fade+2-volume);
+          samples[i] = ulawTable[wavSamples[i]] >> shift;
+        }
+      }
+      else if (state.codec == CODEC_ID_ADPCM_IMA) {
+        read = decodeAdpcm(state.adpcm, wavSamples, read, samples, AUDIO_BUFFER_SIZE / state.resampleRatio, shift);
+      }
+      else {
+        read = 0;
+      }
+
+      // then resampled in place, from the end
+      uint8_t ratio = state.resampleRatio;
+      if (ratio > 1) {
+        for (int i=read-1; i>=0; i--) {
+          int16_t value = samples[i];
+          int16_t * dest = &samples[i*ratio];
+          for (uint8_t j=0; j<ratio; j++) {
+            dest[j] = value;
           }
         }
       }
 
-      return samples - buffer->data;
+      return read * ratio;
     }
   }
 
   return -result;
 }
 #else
-int WavContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
+int WavContext::renderBuffer(int16_t * samples, int volume, unsigned int fade)
 {
   return 0;
 }
 #endif
 
-const unsigned int toneVolumes[] = { 10, 8, 6, 4, 2 };
-inline float evalVolumeRatio(int freq, int volume)
+int MixedContext::renderBuffer(int16_t * samples, int toneVolume, int wavVolume, unsigned int fade)
+{
+  int result = 0;
+  if (fragment.type == FRAGMENT_TONE) {
+    result = tone.renderBuffer(samples, toneVolume, fade);
+  }
+  else if (fragment.type == FRAGMENT_FILE) {
+    result = wav.renderBuffer(samples, wavVolume, fade);
+    if (result < 0) {
+      wav.clear();
+    }
+  }
+  return result;
+}
+
+// 1/toneVolume ratios in Q16, the tones volumes being { 10, 8, 6, 4, 2 }
+const uint32_t toneGains[] = { 6554, 8192, 10923, 16384, 32768 };
+
+// the low tones are louder to compensate the speaker response
+uint32_t evalToneGain(unsigned int freq, int volume)
 {
-  float result = toneVolumes[2+volume];
-  if (freq < 330) {
-    result = (result * freq * freq) / (330 * 330);
+  uint32_t result = toneGains[2+volume];
+  if (freq == 0) {
+    result = 0;
+  }
+  else if (freq < 330) {
+    result = (result * (330 * 330)) / (freq * freq);
   }
   return result;
 }
 
-int ToneContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
+// the DDS phase is in 1/AUDIO_SAMPLE_RATE of sineValues[] entries, the step is then an integer and the phase never drifts
+#define TONE_PHASE_END  (DIM(sineValues) * AUDIO_SAMPLE_RATE)
+
+inline int applyToneGain(int value, uint32_t gain)
+{
+  // rounded towards 0 as the former float division
+  return value >= 0 ? (int)(((uint64_t)value * gain) >> 16) : -(int)(((uint64_t)-value * gain) >> 16);
+}
+
+int ToneContext::renderBuffer(int16_t * samples, int volume, unsigned int fade)
 {
   int duration = 0;
   int result = 0;
+  int points = 0;
 
   int remainingDuration = fragment.tone.duration - state.duration;
   if (remainingDuration > 0) {
-    int points;
-    double toneIdx = state.idx;
+    uint32_t toneIdx = state.idx;
 
     if (fragment.tone.reset) {
       fragment.tone.reset = 0;
@@ -672,8 +1073,8 @@ int ToneContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
 
     if (fragment.tone.freq != state.freq) {
       state.freq = fragment.tone.freq;
-      state.step = double(DIM(sineValues)*fragment.tone.freq) / AUDIO_SAMPLE_RATE;
-      state.volume = evalVolumeRatio(fragment.tone.freq, volume);
+      state.step = DIM(sineValues) * fragment.tone.freq;
+      state.gain = evalToneGain(fragment.tone.freq, volume);
     }
 
     if (fragment.tone.freqIncr) {
@@ -685,22 +1086,23 @@ int ToneContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
       points = AUDIO_BUFFER_SIZE;
     }
     else {
+      // the tone ends at the end of a period
       duration = remainingDuration;
       points = (duration * AUDIO_BUFFER_SIZE) / AUDIO_BUFFER_DURATION;
-      unsigned int end = toneIdx + (state.step * points);
+      uint64_t end = (toneIdx + (uint64_t)state.step * points) / AUDIO_SAMPLE_RATE;
       if (end > DIM(sineValues))
         end -= (end % DIM(sineValues));
       else
         end = DIM(sineValues);
-      points = (double(end) - toneIdx) / state.step;
+      points = state.step ? (end * AUDIO_SAMPLE_RATE - toneIdx) / state.step : 0;
     }
 
     for (int i=0; i<points; i++) {
-      int16_t sample = sineValues[int(toneIdx)] / state.volume;
-      mixSample(&buffer->data[i], sample, fade);
+      // the low tones gain can exceed 1 at the high volumes
+      samples[i] = limit<int>(-32768, applyToneGain(sineValues[toneIdx / AUDIO_SAMPLE_RATE], state.gain) >> fade, 32767);
       toneIdx += state.step;
-      if ((unsigned int)toneIdx >= DIM(sineValues))
-        toneIdx -= DIM(sineValues);
+      if (toneIdx >= TONE_PHASE_END)
+        toneIdx -= TONE_PHASE_END;
     }
 
     if (remainingDuration > AUDIO_BUFFER_DURATION) {
@@ -716,60 +1118,74 @@ int ToneContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
   remainingDuration = fragment.tone.pause - state.pause;
   if (remainingDuration > 0) {
     result = AUDIO_BUFFER_SIZE;
+    memset(&samples[points], 0, (AUDIO_BUFFER_SIZE-points) * sizeof(int16_t));
     state.pause += min<unsigned int>(AUDIO_BUFFER_DURATION-duration, fragment.tone.pause);
     if (fragment.tone.pause > state.pause)
       return result;
   }
 
   clear();
-  return result;
+  // the last period of the tone is also played when no pause follows
+  return max(result, points);
 }
 
 void AudioQueue::wakeup()
 {
+#if defined(SDCARD)
+  if (ridx == widx && normalContext.fragment.type != FRAGMENT_FILE && backgroundContext.fragment.type != FRAGMENT_FILE) {
+    audioCache.wakeup();
+  }
+#endif
+
   int result;
   AudioBuffer *buffer = getEmptyBuffer();
   if (buffer) {
     unsigned int fade = 0;
     int size = 0;
-
-    // write silence in the buffer
-    for (uint32_t i=0; i<AUDIO_BUFFER_SIZE; i++) {
-#if defined(SIMU_AUDIO)
-      buffer->data[i] = 0x8000; /* silence */
-#else
-      buffer->data[i] = 0x8000 >> 4; /* silence */
-#endif
+    bool playing = false;
+
+    memset(audioMixBuffer, 0, sizeof(audioMixBuffer));
+    buffer->latencyContext = 0;
+
+    // mix the priority voices (only tones), they all play together
+    for (int i=0; i<AUDIO_PRIORITY_VOICES; i++) {
+      // the fragment may be cleared by renderBuffer()
+      AudioFragment & fragment = priorityContexts[i].fragment;
+      uint8_t latencyContext = fragment.latencyContext;
+      AudioTimestamp queued = fragment.queued;
+      fragment.latencyContext = 0;
+      result = priorityContexts[i].renderBuffer(audioVoiceBuffer, g_eeGeneral.beepVolume, fade);
+      if (result > 0) {
+        mixSamples(audioMixBuffer, audioVoiceBuffer, result);
+        size = max(size, result);
+        playing = true;
+        if (latencyContext) {
+          recordFillLatency(buffer, latencyContext, queued);
+        }
+      }
     }
-
-    // mix the priority context (only tones)
-    result = priorityContext.mixBuffer(buffer, g_eeGeneral.beepVolume, fade);
-    if (result > 0) {
-      size = result;
+    if (playing) {
       fade += 1;
     }
 
     // mix the normal context (tones and wavs)
-    if (normalContext.fragment.type == FRAGMENT_TONE) {
-      result = normalContext.tone.mixBuffer(buffer, g_eeGeneral.beepVolume, fade);
-    }
-    else if (normalContext.fragment.type == FRAGMENT_FILE) {
-      result = normalContext.wav.mixBuffer(buffer, g_eeGeneral.wavVolume, fade);
-      if (result < 0) {
-        normalContext.wav.clear();
-      }
-    }
-    else {
-      result = 0;
-    }
+    uint8_t latencyContext = normalContext.fragment.latencyContext;
+    AudioTimestamp queued = normalContext.fragment.queued;
+    normalContext.fragment.latencyContext = 0;
+    result = normalContext.renderBuffer(audioVoiceBuffer, g_eeGeneral.beepVolume, g_eeGeneral.wavVolume, fade);
     if (result > 0) {
+      mixSamples(audioMixBuffer, audioVoiceBuffer, result);
       size = max(size, result);
       fade += 1;
+      if (latencyContext) {
+        recordFillLatency(buffer, latencyContext, queued);
+      }
     }
-    else {
+    if (normalContext.fragment.type == FRAGMENT_EMPTY) {
       CoEnterMutexSection(audioMutex);
       if (ridx != widx) {
         normalContext.tone.setFragment(fragments[ridx]);
+        fragments[ridx].latencyContext = 0;   // the repetitions are not new events
         if (!fragments[ridx].repeat--) {
           ridx = (ridx + 1) % AUDIO_QUEUE_LENGTH;
         }
@@ -778,29 +1194,159 @@ void AudioQueue::wakeup()
     }
 
     // mix the vario context
-    result = varioContext.mixBuffer(buffer, g_eeGeneral.varioVolume, fade);
+    result = varioContext.renderBuffer(audioVoiceBuffer, g_eeGeneral.varioVolume, fade);
     if (result > 0) {
+      mixSamples(audioMixBuffer, audioVoiceBuffer, result);
       size = max(size, result);
       fade += 1;
     }
 
     // mix the background context
     if (isFunctionActive(FUNCTION_BACKGND_MUSIC) && !isFunctionActive(FUNCTION_BACKGND_MUSIC_PAUSE)) {
-      result = backgroundContext.mixBuffer(buffer, g_eeGeneral.backgroundVolume, fade);
+      result = backgroundContext.renderBuffer(audioVoiceBuffer, g_eeGeneral.backgroundVolume, fade);
       if (result > 0) {
+        mixSamples(audioMixBuffer, audioVoiceBuffer, result);
         size = max(size, result);
       }
     }
 
     // push the buffer if needed
     if (size > 0) {
+      convertSamples(buffer->data, audioMixBuffer, size);
       __disable_irq();
       // TRACE("pushing buffer %d\n", bufferWIdx);
       bufferWIdx = nextBufferIdx(bufferWIdx);
       buffer->size = size;
-      buffer->state = dacQueue(buffer) ? AUDIO_BUFFER_PLAYING : AUDIO_BUFFER_FILLED;
+      active = hasPendingSamples();
+      if (dacQueue(buffer)) {
+        buffer->state = AUDIO_BUFFER_PLAYING;
+        if (buffer->latencyContext) {
+          recordDacLatency(buffer);
+        }
+      }
+      else {
+        buffer->state = AUDIO_BUFFER_FILLED;
+      }
       __enable_irq();
     }
+    else {
+      active = false;
+    }
+  }
+
+#if defined(SIMU)
+  static uint32_t tracedUnderruns = 0;
+  if (underruns != tracedUnderruns) {
+    tracedUnderruns = underruns;
+    TRACE("Audio underrun (%u)", (unsigned)underruns);
+  }
+#endif
+}
+
+bool AudioQueue::hasPendingSamples()
+{
+  for (int i=0; i<AUDIO_PRIORITY_VOICES; i++) {
+    if (priorityContexts[i].fragment.type != FRAGMENT_EMPTY) {
+      return true;
+    }
+  }
+
+  return normalContext.fragment.type != FRAGMENT_EMPTY || ridx != widx || varioContext.fragment.type != FRAGMENT_EMPTY ||
+         (backgroundContext.fragment.type != FRAGMENT_EMPTY && isFunctionActive(FUNCTION_BACKGND_MUSIC) && !isFunctionActive(FUNCTION_BACKGND_MUSIC_PAUSE));
+}
+
+const char * const audioLatencyContextNames[AUDIO_LATENCY_CONTEXTS] = {
+  "Beep",
+  "Tone",
+  "File",
+};
+
+void getAudioTimestamp(AudioTimestamp & timestamp)
+{
+  timestamp.ticks = get_tmr10ms();
+  timestamp.time = getProfilerTime();
+}
+
+// in us, the 2MHz timer of the radio wraps after 32ms, the longer latencies are only precise to 10ms
+uint32_t getAudioLatency(const AudioTimestamp & timestamp)
+{
+  AudioTimestamp now;
+  getAudioTimestamp(now);
+#if defined(SIMU)
+  return PROFILER_DURATION_US(now.time - timestamp.time);
+#else
+  tmr10ms_t ticks = now.ticks - timestamp.ticks;
+  if (ticks < 3)
+    return PROFILER_DURATION_US((profiler_time_t)(now.time - timestamp.time));
+  else
+    return ticks * 10000;
+#endif
+}
+
+uint8_t audioLatencyBucket(uint32_t latency)
+{
+  uint8_t bucket = 0;
+  latency /= 1000;
+  while (latency && bucket < AUDIO_LATENCY_BUCKETS-1) {
+    latency >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+void AudioLatencyHistogram::record(uint32_t latency)
+{
+  if (latency > max) max = latency;
+  count++;
+  buckets[audioLatencyBucket(latency)]++;
+}
+
+void AudioQueue::recordFillLatency(AudioBuffer * buffer, uint8_t context, const AudioTimestamp & queued)
+{
+  latencies[context-1].fill.record(getAudioLatency(queued));
+  // only the first event of a buffer is followed until the DAC
+  if (!buffer->latencyContext) {
+    buffer->latencyContext = context;
+    buffer->queued = queued;
+  }
+}
+
+// called from the DAC interrupt
+void AudioQueue::recordDacLatency(AudioBuffer * buffer)
+{
+  uint32_t latency = getAudioLatency(buffer->queued);
+  latencies[buffer->latencyContext-1].dac.record(latency);
+#if defined(SIMU)
+  TRACE("Audio %s latency %uus", audioLatencyContextNames[buffer->latencyContext-1], (unsigned)latency);
+#endif
+  buffer->latencyContext = 0;
+}
+
+void AudioQueue::resetStats()
+{
+  underruns = 0;
+  memclear(latencies, sizeof(latencies));
+}
+
+void AudioQueue::dumpStats(void (*output)(const char *))
+{
+  char line[128];
+
+  snprintf(line, sizeof(line), "Underruns %u", (unsigned)underruns);
+  output(line);
+  output("Event      Count    Max [us] | <1 <2 <4 <8 <16 <32 <64 >64 [ms]");
+
+  for (uint8_t i=0; i<AUDIO_LATENCY_CONTEXTS; i++) {
+    for (uint8_t j=0; j<2; j++) {
+      const AudioLatencyHistogram & histogram = (j == 0 ? latencies[i].fill : latencies[i].dac);
+      if (histogram.count == 0) continue;
+      int len = snprintf(line, sizeof(line), "%-4s %-4s %6u %10u |", audioLatencyContextNames[i], j == 0 ? "Fill" : "DAC",
+                         (unsigned)histogram.count, (unsigned)histogram.max);
+      for (uint8_t k=0; k<AUDIO_LATENCY_BUCKETS && len>0 && len<(int)sizeof(line); k++) {
+        len += snprintf(line+len, sizeof(line)-len, " %u", (unsigned)histogram.buckets[k]);
+      }
+      output(line);
+    }
   }
 }
 
@@ -861,15 +1407,20 @@ void AudioQueue::playTone(uint16_t freq, uint16_t len, uint16_t pause, uint8_t f
     len = getToneLength(len);
 
     if (flags & PLAY_NOW) {
-      AudioFragment & fragment = priorityContext.fragment;
-      if (fragment.type == FRAGMENT_EMPTY) {
-        priorityContext.clear();
-        fragment.type = FRAGMENT_TONE;
-        fragment.repeat = flags & 0x0f;
-        fragment.tone.freq = freq;
-        fragment.tone.duration = len;
-        fragment.tone.pause = pause;
-        fragment.tone.freqIncr = freqIncr;
+      // the tone takes the first free voice, it is dropped if they are all busy
+      for (int i=0; i<AUDIO_PRIORITY_VOICES; i++) {
+        AudioFragment & fragment = priorityContexts[i].fragment;
+        if (fragment.type == FRAGMENT_EMPTY) {
+          priorityContexts[i].clear();
+          fragment.type = FRAGMENT_TONE;
+          fragment.repeat = flags & 0x0f;
+          fragment.tone.freq = freq;
+          fragment.tone.duration = len;
+          fragment.tone.pause = pause;
+          fragment.tone.freqIncr = freqIncr;
+          fragment.setQueued(AUDIO_LATENCY_BEEP);
+          break;
+        }
       }
     }
     else {
@@ -883,6 +1434,7 @@ void AudioQueue::playTone(uint16_t freq, uint16_t len, uint16_t pause, uint8_t f
         fragment.tone.duration = len;
         fragment.tone.pause = pause;
         fragment.tone.freqIncr = freqIncr;
+        fragment.setQueued(AUDIO_LATENCY_TONE);
         widx = next_widx;
       }
     }
@@ -935,6 +1487,7 @@ void AudioQueue::playFile(const char *filename, uint8_t flags, uint8_t id)
       strcpy(fragment.file, filename);
       fragment.repeat = flags & 0x0f;
       fragment.id = id;
+      fragment.setQueued(AUDIO_LATENCY_FILE);
       widx = next_widx;
     }
   }
@@ -962,6 +1515,7 @@ void AudioQueue::stopPlay(uint8_t id)
 void AudioQueue::stopSD()
 {
   sdAvailableSystemAudioFiles = 0;
+  audioCache.requestFlush();
   stopAll();
   playTone(0, 0, 100, PLAY_NOW);        // insert a 100ms pause
 }
@@ -972,7 +1526,9 @@ void AudioQueue::stopAll()
 {
   CoEnterMutexSection(audioMutex);
   widx = ridx;                      // clean the queue
-  priorityContext.clear();
+  for (int i=0; i<AUDIO_PRIORITY_VOICES; i++) {
+    priorityContexts[i].clear();
+  }
   normalContext.fragment.clear();
   varioContext.clear();
   backgroundContext.clear();
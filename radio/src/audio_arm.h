@@ -51,6 +51,7 @@
 #else
   #define AUDIO_BUFFER_COUNT  (3)
 #endif
+#define AUDIO_PRIORITY_VOICES (3)       // PLAY_NOW tones which can sound together
 
 #define BEEP_MIN_FREQ         (150)
 #define BEEP_DEFAULT_FREQ     (2250)
@@ -61,14 +62,56 @@
 #define AUDIO_BUFFER_FILLED   (1)
 #define AUDIO_BUFFER_PLAYING  (2)
 
+// Latency instrumentation: the events are timestamped when queued, then when
+// their first samples are mixed in a buffer, and when the DAC starts this buffer
+enum AudioLatencyContexts {
+  AUDIO_LATENCY_BEEP,   // PLAY_NOW tones
+  AUDIO_LATENCY_TONE,
+  AUDIO_LATENCY_FILE,
+  AUDIO_LATENCY_CONTEXTS
+};
+
+// bucket n counts the latencies in [2^(n-1), 2^n[ ms, the last one everything above 64ms
+#define AUDIO_LATENCY_BUCKETS (8)
+
+struct AudioTimestamp {
+  tmr10ms_t ticks;
+  profiler_time_t time;
+};
+
+struct AudioLatencyHistogram {
+  uint32_t count;
+  uint32_t max;         // us
+  uint32_t buckets[AUDIO_LATENCY_BUCKETS];
+
+  void record(uint32_t latency);
+};
+
+struct AudioLatencyStats {
+  AudioLatencyHistogram fill;
+  AudioLatencyHistogram dac;
+};
+
+extern const char * const audioLatencyContextNames[AUDIO_LATENCY_CONTEXTS];
+
+void getAudioTimestamp(AudioTimestamp & timestamp);
+uint32_t getAudioLatency(const AudioTimestamp & timestamp);
+uint8_t audioLatencyBucket(uint32_t latency);
+
 struct AudioBuffer {
   uint16_t data[AUDIO_BUFFER_SIZE];
   uint16_t size;
   uint8_t  state;
+  uint8_t  latencyContext;    // the context+1 of the first event mixed in this buffer, 0 if none
+  AudioTimestamp queued;
 };
 
 extern AudioBuffer audioBuffers[AUDIO_BUFFER_COUNT];
 
+extern const int16_t sineValues[1024];
+
+void mixSamples(int16_t * result, const int16_t * samples, unsigned int count);
+
 enum FragmentTypes {
   FRAGMENT_EMPTY,
   FRAGMENT_TONE,
@@ -79,6 +122,8 @@ struct AudioFragment {
   uint8_t type;
   uint8_t id;
   uint8_t repeat;
+  uint8_t latencyContext;     // the context+1 while the fragment has not been mixed yet, 0 if not traced
+  AudioTimestamp queued;
   union {
     struct {
       uint16_t freq;
@@ -95,6 +140,12 @@ struct AudioFragment {
   {
     memset(this, 0, sizeof(AudioFragment));
   }
+
+  void setQueued(uint8_t context)
+  {
+    latencyContext = context + 1;
+    getAudioTimestamp(queued);
+  }
 };
 
 class ToneContext {
@@ -102,9 +153,9 @@ class ToneContext {
     AudioFragment fragment;
 
     struct {
-      double step;
-      double idx;
-      float  volume;
+      uint32_t step;
+      uint32_t idx;
+      uint32_t gain;
       uint16_t freq;
       uint16_t duration;
       uint16_t pause;
@@ -121,9 +172,114 @@ class ToneContext {
       memset(this, 0, sizeof(ToneContext));
     }
 
-    int mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade);
+    int renderBuffer(int16_t * samples, int volume, unsigned int fade);
 };
 
+struct WavHeader {
+  uint8_t  codec;
+  uint8_t  resampleRatio;
+  uint32_t offset;      // offset of the samples in the file
+  uint32_t size;        // size of the samples
+  uint16_t blockSize;   // IMA-ADPCM block size
+};
+
+// IMA-ADPCM decoder state, kept between the reads of a file
+struct AdpcmState {
+  int16_t  predictor;
+  uint8_t  index;
+  uint8_t  nibble;          // high nibble of the last byte, when there was no room left for its sample
+  bool     nibblePending;
+  uint16_t blockSize;
+  uint16_t blockPos;
+};
+
+unsigned int getAdpcmReadSize(const AdpcmState & state, unsigned int count);
+unsigned int decodeAdpcm(AdpcmState & state, const uint8_t * data, unsigned int size, int16_t * samples, unsigned int count, unsigned int shift);
+
+#if defined(SDCARD)
+// LRU cache of the prompts: the parsed headers, and the samples of the short files
+#if !defined(AUDIO_CACHE_SIZE)
+  #if defined(REV9E)
+    #define AUDIO_CACHE_SIZE        32768
+  #elif defined(PCBTARANIS)
+    #define AUDIO_CACHE_SIZE        16384
+  #else
+    #define AUDIO_CACHE_SIZE        4096
+  #endif
+#endif
+#define AUDIO_CACHE_ENTRIES         16
+#define AUDIO_CACHE_MAX_FILE_SIZE   (AUDIO_CACHE_SIZE/2)
+
+struct AudioCacheEntry {
+  char      path[AUDIO_FILENAME_MAXLEN+1];
+  WavHeader header;
+  uint32_t  dataPos;    // position of the samples in the cache buffer
+  uint32_t  dataSize;   // space reserved for the samples, 0 when only the header is cached
+  uint32_t  loaded;     // bytes of samples loaded
+  tmr10ms_t lastUsed;
+
+  bool isComplete() const
+  {
+    return dataSize && loaded == header.size;
+  }
+};
+
+class AudioCache {
+  public:
+    uint32_t hits;
+    uint32_t misses;
+
+    AudioCacheEntry * find(const char * path);
+
+    AudioCacheEntry * add(const char * path, const WavHeader & header, bool evict=true);
+
+    const uint8_t * getData(const AudioCacheEntry * entry)
+    {
+      return data + entry->dataPos;
+    }
+
+    void reserve(AudioCacheEntry * entry, bool evict=true);
+
+    void load(AudioCacheEntry * entry, uint32_t pos, const uint8_t * samples, uint32_t count);
+
+    uint32_t used()
+    {
+      return dataUsed;
+    }
+
+    void requestWarmup()
+    {
+      warmupIndex = 0;
+    }
+
+    void requestFlush()
+    {
+      flushRequested = true;
+    }
+
+    void wakeup();
+
+    void resetStats()
+    {
+      hits = misses = 0;
+    }
+
+  protected:
+    AudioCacheEntry entries[AUDIO_CACHE_ENTRIES];
+    uint8_t data[AUDIO_CACHE_SIZE] __attribute__((aligned(4)));
+    uint32_t dataUsed;
+    volatile uint16_t warmupIndex;
+    volatile bool flushRequested;
+
+    AudioCacheEntry * getFreeEntry(bool evict);
+    bool releaseData(bool evict);
+    void releaseData(AudioCacheEntry * entry);
+    void preload(const char * path);
+};
+
+extern AudioCache audioCache;
+#endif
+
 class WavContext {
   public:
     AudioFragment fragment;
@@ -131,10 +287,15 @@ class WavContext {
     struct {
       FIL      file;
       uint8_t  codec;
-      uint32_t freq;
       uint32_t size;
       uint8_t  resampleRatio;
       uint16_t readSize;
+#if defined(SDCARD)
+      AudioCacheEntry * cache;  // entry being played from RAM, or being loaded while played from the SD
+      uint32_t pos;
+      bool     cached;
+      AdpcmState adpcm;
+#endif
     } state;
 
     inline void clear()
@@ -142,7 +303,7 @@ class WavContext {
       fragment.clear();
     }
 
-    int mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade);
+    int renderBuffer(int16_t * samples, int volume, unsigned int fade);
 };
 
 class MixedContext {
@@ -153,7 +314,7 @@ class MixedContext {
       WavContext wav;
     };
 
-    int mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade);
+    int renderBuffer(int16_t * samples, int toneVolume, int wavVolume, unsigned int fade);
 };
 
 bool dacQueue(AudioBuffer *buffer);
@@ -187,6 +348,18 @@ class AudioQueue {
 
     bool isPlaying(uint8_t id);
 
+#if defined(SDCARD)
+    bool isCacheEntryUsed(const AudioCacheEntry * entry);
+#endif
+
+    // DAC requests which found no filled buffer while samples were still expected
+    uint32_t underruns;
+    AudioLatencyStats latencies[AUDIO_LATENCY_CONTEXTS];
+
+    void resetStats();
+
+    void dumpStats(void (*output)(const char *));
+
     bool started()
     {
       return state;
@@ -210,11 +383,17 @@ class AudioQueue {
         if (buffer->state == AUDIO_BUFFER_FILLED) {
           buffer->state = AUDIO_BUFFER_PLAYING;
           bufferRIdx = idx;
+          if (buffer->latencyContext) {
+            recordDacLatency(buffer);
+          }
           return buffer;
         }
         idx = nextBufferIdx(idx);
       } while (idx != bufferWIdx);   //this fixes a bug if all buffers are filled
 
+      if (active) {
+        underruns++;
+      }
       return NULL;
     }
 
@@ -234,7 +413,14 @@ class AudioQueue {
 
     void wakeup();
 
+    bool hasPendingSamples();
+
+    void recordFillLatency(AudioBuffer * buffer, uint8_t context, const AudioTimestamp & queued);
+
+    void recordDacLatency(AudioBuffer * buffer);
+
     volatile bool state;
+    volatile bool active;   // the DAC should find a filled buffer at its next request
     uint8_t ridx;
     uint8_t widx;
 
@@ -242,7 +428,7 @@ class AudioQueue {
 
     MixedContext normalContext;
     WavContext   backgroundContext;
-    ToneContext  priorityContext;
+    ToneContext  priorityContexts[AUDIO_PRIORITY_VOICES];
     ToneContext  varioContext;
 
     uint8_t bufferRIdx;
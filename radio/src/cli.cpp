@@ -89,6 +89,25 @@ int toInt(const char ** argv, int index, int * val)
   }
 }
 
+void cliAudioOutput(const char * line)
+{
+  serialPrint("%s", line);
+}
+
+int cliAudio(const char ** argv)
+{
+  if (argv[1][0] == '\0') {
+    audioQueue.dumpStats(cliAudioOutput);
+  }
+  else if (!strcmp(argv[1], "reset")) {
+    audioQueue.resetStats();
+  }
+  else {
+    serialPrint("%s: Invalid argument \"%s\"", argv[0], argv[1]);
+  }
+  return 0;
+}
+
 int cliBeep(const char ** argv)
 {
   int freq = BEEP_DEFAULT_FREQ;
@@ -188,6 +207,27 @@ int cliStackInfo(const char ** argv)
   return 0;
 }
 
+#if defined(MIXER_PROFILER)
+void cliProfilerOutput(const char * line)
+{
+  serialPrint("%s", line);
+}
+
+int cliProfiler(const char ** argv)
+{
+  if (argv[1][0] == '\0') {
+    mixerProfilerDump(cliProfilerOutput);
+  }
+  else if (!strcmp(argv[1], "reset")) {
+    mixerProfilerReset();
+  }
+  else {
+    serialPrint("%s: Invalid argument \"%s\"", argv[0], argv[1]);
+  }
+  return 0;
+}
+#endif
+
 int cliVolume(const char ** argv)
 {
   int level = 0;
@@ -252,10 +292,14 @@ int cliDisplay(const char ** argv)
 int cliHelp(const char ** argv);
 
 const CliCommand cliCommands[] = {
+  { "audio", cliAudio, "[reset]" },
   { "beep", cliBeep, "[<frequency>] [<duration>]" },
   { "ls", cliLs, "<directory>" },
   { "play", cliPlay, "<filename>" },
   { "print", cliDisplay, "<address> [<size>] | <what>" },
+#if defined(MIXER_PROFILER)
+  { "profiler", cliProfiler, "[reset]" },
+#endif
   { "stackinfo", cliStackInfo, "<tid>" },
   { "trace", cliTrace, "on | off" },
   { "volume", cliVolume, "<level>" },
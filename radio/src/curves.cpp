@@ -57,6 +57,7 @@ void loadCurves()
     }
     curveEnd[i] = tmp;
   }
+  invalidateCurvesCache();
 }
 int8_t *curveAddress(uint8_t idx)
 {
@@ -152,6 +153,78 @@ s32 compute_tangent(CurveInfo *crv, int8_t *points, int i)
     return m;
 }
 
+/* Everything in a curve which doesn't depend on x (segment bounds, tangents)
+   is computed once and kept until the curves are modified, which turns
+   the segment lookup into a binary search and removes the 2 calls to
+   compute_tangent() from each hermite_spline() call
+*/
+struct CurveCache {
+  bool valid;
+  bool sorted;                // bounds are ascending and inside -RESX..RESX
+  int16_t x[MAX_POINTS];      // segment bounds
+  s32 tangents[MAX_POINTS];
+};
+
+CurveCache curvesCache[MAX_CURVES];
+
+void invalidateCurvesCache()
+{
+  for (int i=0; i<MAX_CURVES; i++) {
+    curvesCache[i].valid = false;
+  }
+}
+
+CurveCache & getCurveCache(uint8_t idx)
+{
+  CurveCache & cache = curvesCache[idx];
+  if (!cache.valid) {
+    CurveInfo &crv = g_model.curves[idx];
+    int8_t *points = curveAddress(idx);
+    uint8_t count = crv.points+5;
+    bool custom = (crv.type == CURVE_TYPE_CUSTOM);
+    cache.sorted = true;
+    for (int i=0; i<count; i++) {
+      if (i == 0)
+        cache.x[i] = -RESX;
+      else if (i == count-1)
+        cache.x[i] = RESX;
+      else if (custom)
+        cache.x[i] = calc100toRESX(points[count+i-1]);
+      else
+        cache.x[i] = -RESX + (i*2*RESX)/(count-1);
+      if (i > 0 && (cache.x[i] < cache.x[i-1] || cache.x[i] > RESX))
+        cache.sorted = false;
+      cache.tangents[i] = compute_tangent(&crv, points, i);
+    }
+    cache.valid = true;
+  }
+  return cache;
+}
+
+// returns the segment i such as x[i] <= x <= x[i+1], the first one when
+// several segments match (x on a bound, or 2 points with the same x)
+uint8_t findCurveSegment(CurveCache & cache, uint8_t count, int16_t x)
+{
+  if (cache.sorted) {
+    uint8_t lo = 1, hi = count-1;
+    while (lo < hi) {
+      uint8_t mid = (lo + hi) / 2;
+      if (x <= cache.x[mid])
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+    return lo - 1;
+  }
+  else {
+    for (int i=0; i<count-2; i++) {
+      if (x >= cache.x[i] && x <= cache.x[i+1])
+        return i;
+    }
+    return count-2;
+  }
+}
+
 /* The following is a hermite cubic spline.
    The basis functions can be found here:
    http://en.wikipedia.org/wiki/Cubic_Hermite_spline
@@ -162,44 +235,35 @@ int16_t hermite_spline(int16_t x, uint8_t idx)
   CurveInfo &crv = g_model.curves[idx];
   int8_t *points = curveAddress(idx);
   uint8_t count = crv.points+5;
-  bool custom = (crv.type == CURVE_TYPE_CUSTOM);
+  CurveCache & cache = getCurveCache(idx);
 
   if (x < -RESX)
     x = -RESX;
   else if (x > RESX)
     x = RESX;
 
-  for (int i=0; i<count-1; i++) {
-    s32 p0x, p3x;
-    if (custom) {
-      p0x = (i>0 ? calc100toRESX(points[count+i-1]) : -RESX);
-      p3x = (i<count-2 ? calc100toRESX(points[count+i]) : RESX);
-    }
-    else {
-      p0x = -RESX + (i*2*RESX)/(count-1);
-      p3x = -RESX + ((i+1)*2*RESX)/(count-1);
-    }
+  uint8_t i = findCurveSegment(cache, count, x);
+  s32 p0x = cache.x[i];
+  s32 p3x = cache.x[i+1];
+  if (x < p0x || x > p3x)
+    return 0;
 
-    if (x >= p0x && x <= p3x) {
-      s32 p0y = calc100toRESX(points[i]);
-      s32 p3y = calc100toRESX(points[i+1]);
-      s32 m0 = compute_tangent(&crv, points, i);
-      s32 m3 = compute_tangent(&crv, points, i+1);
-      s32 y;
-      s32 h = p3x - p0x;
-      s32 t = (h > 0 ? (MMULT * (x - p0x)) / h : 0);
-      s32 t2 = t * t / MMULT;
-      s32 t3 = t2 * t / MMULT;
-      s32 h00 = 2*t3 - 3*t2 + MMULT;
-      s32 h10 = t3 - 2*t2 + t;
-      s32 h01 = -2*t3 + 3*t2;
-      s32 h11 = t3 - t2;
-      y = p0y * h00 + h * (m0 * h10 / MMULT) + p3y * h01 + h * (m3 * h11 / MMULT);
-      y /= MMULT;
-      return y;
-    }
-  }
-  return 0;
+  s32 p0y = calc100toRESX(points[i]);
+  s32 p3y = calc100toRESX(points[i+1]);
+  s32 m0 = cache.tangents[i];
+  s32 m3 = cache.tangents[i+1];
+  s32 y;
+  s32 h = p3x - p0x;
+  s32 t = (h > 0 ? (MMULT * (x - p0x)) / h : 0);
+  s32 t2 = t * t / MMULT;
+  s32 t3 = t2 * t / MMULT;
+  s32 h00 = 2*t3 - 3*t2 + MMULT;
+  s32 h10 = t3 - 2*t2 + t;
+  s32 h01 = -2*t3 + 3*t2;
+  s32 h11 = t3 - t2;
+  y = p0y * h00 + h * (m0 * h10 / MMULT) + p3y * h01 + h * (m3 * h11 / MMULT);
+  y /= MMULT;
+  return y;
 }
 #endif
 
@@ -230,6 +294,15 @@ int intpol(int x, uint8_t idx) // -100, -75, -50, -25, 0 ,25 ,50, 75, 100
     uint16_t a=0, b=0;
     uint8_t i;
     if (custom) {
+#if defined(XCURVES)
+      CurveCache & cache = getCurveCache(idx);
+      if (cache.sorted) {
+        i = findCurveSegment(cache, count, x-RESX);
+        a = RESX + cache.x[i];
+        b = RESX + cache.x[i+1];
+      }
+      else
+#endif
       for (i=0; i<count-1; i++) {
         a = b;
         b = (i==count-2 ? 2*RESX : RESX + calc100toRESX(points[count+i]));
@@ -435,3 +508,68 @@ int expo(int x, int k)
   }
   return neg? -y : y;
 }
+
+#if defined(CPUARM)
+#if defined(SIMU) && defined(__SSE2__)
+// SSE2 has no 32 bits lanes multiply, it is done with two 32x32->64 multiplies
+static inline __m128i mullo_epi32(__m128i a, __m128i b)
+{
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+#endif
+
+// values[i] = expo(values[i], k) for count values sharing the same k. The k
+// dependent part of expou() is done once, the result is bit-identical to expo()
+void expoBatch(int * values, uint8_t count, int k)
+{
+  if (k == 0) return;
+
+#if defined(EXTENDED_EXPO)
+  for (uint8_t i=0; i<count; i++) {
+    values[i] = expo(values[i], k);
+  }
+#else
+  bool inverted = (k < 0);
+  uint32_t k256 = calc100to256(inverted ? -k : k);
+  uint8_t i = 0;
+
+#if defined(SIMU) && defined(__SSE2__)
+  const __m128i resx = _mm_set1_epi32(RESXu);
+  const __m128i k256v = _mm_set1_epi32(k256);
+  const __m128i k256c = _mm_set1_epi32(256-k256);
+  const __m128i round = _mm_set1_epi32(128);
+  for (; i+4<=count; i+=4) {
+    __m128i x = _mm_loadu_si128((__m128i *)&values[i]);
+    __m128i sign = _mm_srai_epi32(x, 31);
+    x = _mm_sub_epi32(_mm_xor_si128(x, sign), sign);
+    if (inverted) x = _mm_sub_epi32(resx, x);
+    __m128i value = mullo_epi32(x, x);
+    value = _mm_srli_epi32(mullo_epi32(value, k256v), 8);
+    value = _mm_srli_epi32(mullo_epi32(value, x), 12);
+    value = _mm_add_epi32(value, _mm_add_epi32(mullo_epi32(k256c, x), round));
+    value = _mm_srli_epi32(value, 8);
+    if (inverted) value = _mm_sub_epi32(resx, value);
+    value = _mm_sub_epi32(_mm_xor_si128(value, sign), sign);
+    _mm_storeu_si128((__m128i *)&values[i], value);
+  }
+#endif
+
+  for (; i<count; i++) {
+    int y = values[i];
+    bool neg = (y < 0);
+    uint32_t x = (neg ? -y : y);
+    if (inverted) x = RESXu - x;
+    uint32_t value = x*x*k256;
+    value >>= 8;
+    value *= x;
+    value >>= 12;
+    value += (256-k256)*x+128;
+    value >>= 8;
+    y = (inverted ? RESXu - value : value);
+    values[i] = (neg ? -y : y);
+  }
+#endif
+}
+#endif
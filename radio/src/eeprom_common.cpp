@@ -42,13 +42,46 @@
 
 uint8_t   s_eeDirtyMsk;
 tmr10ms_t s_eeDirtyTime10ms;
+#if defined(CPUARM)
+uint8_t   s_eeEditedMsk;
+#endif
+
+void eeInvalidateCaches(uint8_t msk)
+{
+  INVALIDATE_MIXER_FAST_PATH();
+  if (msk & EE_MODEL) {
+    INVALIDATE_MIXER_PLAN();
+    INVALIDATE_CURVES_CACHE();
+    INVALIDATE_GVARS_CACHE();
+    INVALIDATE_TELEMETRY_INDEX();
+    INVALIDATE_LOGICAL_SWITCHES_GRAPH();
+  }
+}
 
 void eeDirty(uint8_t msk)
 {
   s_eeDirtyMsk |= msk;
   s_eeDirtyTime10ms = get_tmr10ms() ;
+  eeInvalidateCaches(msk);
+#if defined(CPUARM)
+  s_eeEditedMsk |= msk;
+#endif
 }
 
+#if defined(CPUARM)
+// checkIncDec() calls eeDirty() before the menu stores the new value, and the
+// mixer task may rebuild its caches in between, from the former value. They are
+// invalidated once more when the menu has returned, the value is stored then.
+void eeCheckEdited()
+{
+  uint8_t msk = s_eeEditedMsk;
+  if (msk) {
+    s_eeEditedMsk = 0;
+    eeInvalidateCaches(msk);
+  }
+}
+#endif
+
 uint8_t eeFindEmptyModel(uint8_t id, bool down)
 {
   uint8_t i = id;
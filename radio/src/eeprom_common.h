@@ -52,6 +52,10 @@ extern uint8_t   s_eeDirtyMsk;
 extern tmr10ms_t s_eeDirtyTime10ms;
 
 void eeDirty(uint8_t msk);
+void eeInvalidateCaches(uint8_t msk);
+#if defined(CPUARM)
+void eeCheckEdited();
+#endif
 void eeCheck(bool immediately);
 void eeReadAll();
 bool eeModelExists(uint8_t id);
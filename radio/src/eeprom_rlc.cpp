@@ -999,6 +999,10 @@ void eeLoadModel(uint8_t id)
 #endif
 
     LOAD_MODEL_CURVES();
+    INVALIDATE_MIXER_PLAN();
+    INVALIDATE_GVARS_CACHE();
+    INVALIDATE_TELEMETRY_INDEX();
+    RESET_MIXER_FAST_PATH_STATS();
 
     resumeMixerCalculations();
     // TODO pulses should be started after mixer calculations ...
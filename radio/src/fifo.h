@@ -37,13 +37,27 @@
 #ifndef _FIFO_H_
 #define _FIFO_H_
 
+/* Single producer / single consumer ring, the producer is usually an interrupt.
+   The data accesses must not be moved across the index updates which publish
+   them: on the radio a compiler barrier is enough, the simulator runs threads
+*/
+#if defined(SIMU) && defined(__GNUC__)
+  #define FIFO_BARRIER()   __sync_synchronize()
+#elif defined(__GNUC__)
+  #define FIFO_BARRIER()   __asm__ __volatile__ ("" ::: "memory")
+#else
+  #define FIFO_BARRIER()
+#endif
+
 template <int N>
 class Fifo
 {
   public:
     Fifo():
       widx(0),
-      ridx(0)
+      ridx(0),
+      overflows(0),
+      highWaterMark(0)
     {
     }
 
@@ -51,21 +65,73 @@ class Fifo
       uint32_t next = (widx+1) & (N-1);
       if (next != ridx) {
         fifo[widx] = byte;
+        FIFO_BARRIER();
         widx = next;
+        updateHighWaterMark();
+      }
+      else {
+        overflows++;
       }
     }
 
+    // the bytes which don't fit are dropped and counted as overflows
+    uint32_t push(const uint8_t * data, uint32_t count) {
+      uint32_t w = widx;
+      uint32_t free = (ridx - w - 1) & (N-1);
+      if (count > free) {
+        overflows += count - free;
+        count = free;
+      }
+      uint32_t first = (count < N - w) ? count : N - w;
+      memcpy(&fifo[w], data, first);
+      memcpy(&fifo[0], data + first, count - first);
+      FIFO_BARRIER();
+      widx = (w + count) & (N-1);
+      updateHighWaterMark();
+      return count;
+    }
+
     bool pop(uint8_t & byte) {
       if (isEmpty()) {
         return false;
       }
       else {
+        FIFO_BARRIER();
         byte = fifo[ridx];
+        FIFO_BARRIER();
         ridx = (ridx+1) & (N-1);
         return true;
       }
     }
 
+    uint32_t pop(uint8_t * data, uint32_t count) {
+      const uint8_t * span;
+      uint32_t result = 0;
+      uint32_t len;
+      while (result < count && (len = getSpan(span)) > 0) {
+        if (len > count - result)
+          len = count - result;
+        memcpy(data + result, span, len);
+        skip(len);
+        result += len;
+      }
+      return result;
+    }
+
+    // contiguous bytes available from the read index, they stay in the fifo until skip()
+    uint32_t getSpan(const uint8_t * & data) {
+      uint32_t w = widx;
+      uint32_t r = ridx;
+      FIFO_BARRIER();
+      data = &fifo[r];
+      return (w >= r) ? w - r : N - r;
+    }
+
+    void skip(uint32_t count) {
+      FIFO_BARRIER();
+      ridx = (ridx + count) & (N-1);
+    }
+
     bool isEmpty() {
       return (ridx == widx);
     }
@@ -75,14 +141,44 @@ class Fifo
       return (next == ridx);
     }
 
+    uint32_t size() {
+      return (widx - ridx) & (N-1);
+    }
+
+    uint32_t freeSpace() {
+      return (ridx - widx - 1) & (N-1);
+    }
+
     void flush() {
       while (!isEmpty()) {};
     }
 
+    uint32_t getOverflows() {
+      return overflows;
+    }
+
+    uint32_t getHighWaterMark() {
+      return highWaterMark;
+    }
+
+    void resetStats() {
+      overflows = 0;
+      highWaterMark = 0;
+    }
+
   protected:
     uint8_t fifo[N];
     volatile uint32_t widx;
     volatile uint32_t ridx;
+    uint32_t overflows;
+    uint32_t highWaterMark;
+
+    void updateHighWaterMark() {
+      uint32_t count = size();
+      if (count > highWaterMark) {
+        highWaterMark = count;
+      }
+    }
 };
 
 #endif // _FIFO_H_
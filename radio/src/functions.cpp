@@ -571,6 +571,9 @@ void evalFunctions()
             if (CFN_PARAM(cfn)) {
               newActiveFunctions |= (1 << FUNCTION_LOGS);
               logDelay = CFN_PARAM(cfn);
+#if defined(CPUARM)
+              logsFormat = CFN_LOGS_FORMAT(cfn);
+#endif
             }
             break;
 #endif
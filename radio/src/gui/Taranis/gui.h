@@ -54,6 +54,7 @@ void displayMenuBar(const MenuItem *menu, int index);
 void displayProgressBar(const char *label);
 void updateProgressBar(int num, int den);
 void drawGauge(coord_t x, coord_t y, coord_t w, coord_t h, int32_t val, int32_t max);
+void drawTelemetryHistory(coord_t x, coord_t y, coord_t w, coord_t h, uint8_t index, uint8_t resolution);
 
 extern coord_t scrollbar_X;
 #define SET_SCROLLBAR_X(x) scrollbar_X = (x);
@@ -424,6 +424,12 @@ void menuCustomFunctions(uint8_t event, CustomFunctionData * functions, CustomFu
             }
             if (active) CFN_PLAY_REPEAT(cfn) = checkIncDec(event, CFN_PLAY_REPEAT(cfn)==CFN_PLAY_REPEAT_NOSTART?-1:CFN_PLAY_REPEAT(cfn), -1, 60/CFN_PLAY_REPEAT_MUL, eeFlags);
           }
+#if defined(SDCARD)
+          else if (func == FUNC_LOGS) {
+            lcd_putsiAtt(MODEL_CUSTOM_FUNC_4TH_COLUMN, y, "\003CSVBin", CFN_LOGS_FORMAT(cfn), attr);
+            if (active) CFN_LOGS_FORMAT(cfn) = checkIncDec(event, CFN_LOGS_FORMAT(cfn), LOGS_FORMAT_CSV, LOGS_FORMAT_BINARY, eeFlags);
+          }
+#endif
           else if (attr) {
             REPEAT_LAST_CURSOR_MOVE();
           }
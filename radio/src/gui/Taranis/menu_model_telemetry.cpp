@@ -159,6 +159,7 @@ enum SensorFields {
   SENSOR_FIELD_FILTER,
   SENSOR_FIELD_PERSISTENT,
   SENSOR_FIELD_LOGS,
+  SENSOR_FIELD_HISTORY,
   SENSOR_FIELD_MAX
 };
 
@@ -207,7 +208,7 @@ bool isSensorAvailable(int sensor)
 #define SENSOR_UNIT_ROWS       ((sensor->type == TELEM_TYPE_CALCULATED && (sensor->formula == TELEM_FORMULA_DIST)) || sensor->isConfigurable() ? (uint8_t)0 : HIDDEN_ROW)
 #define SENSOR_PREC_ROWS       (sensor->isPrecConfigurable() && sensor->unit != UNIT_FAHRENHEIT  ? (uint8_t)0 : HIDDEN_ROW)
 #define SENSOR_PARAM1_ROWS     (sensor->unit >= UNIT_FIRST_VIRTUAL ? HIDDEN_ROW : (uint8_t)0)
-#define SENSOR_PARAM2_ROWS     (sensor->unit == UNIT_GPS || sensor->unit == UNIT_DATETIME || sensor->unit == UNIT_CELLS || (sensor->type==TELEM_TYPE_CALCULATED && (sensor->formula==TELEM_FORMULA_CONSUMPTION || sensor->formula==TELEM_FORMULA_TOTALIZE)) ? HIDDEN_ROW : (uint8_t)0)
+#define SENSOR_PARAM2_ROWS     (sensor->unit == UNIT_GPS || sensor->unit == UNIT_DATETIME || sensor->unit == UNIT_CELLS || (sensor->type==TELEM_TYPE_CALCULATED && (sensor->formula==TELEM_FORMULA_CONSUMPTION || sensor->formula==TELEM_FORMULA_TOTALIZE || sensor->formula==TELEM_FORMULA_BEARING)) ? HIDDEN_ROW : (uint8_t)0)
 #define SENSOR_PARAM3_ROWS     (sensor->type == TELEM_TYPE_CALCULATED && sensor->formula < TELEM_FORMULA_MULTIPLY) ? (uint8_t)0 : HIDDEN_ROW
 #define SENSOR_PARAM4_ROWS     (sensor->type == TELEM_TYPE_CALCULATED && sensor->formula < TELEM_FORMULA_MULTIPLY) ? (uint8_t)0 : HIDDEN_ROW
 #define SENSOR_AUTOOFFSET_ROWS (sensor->unit != UNIT_RPMS && sensor->isConfigurable() ? (uint8_t)0 : HIDDEN_ROW)
@@ -219,7 +220,7 @@ void menuModelSensor(uint8_t event)
 {
   TelemetrySensor * sensor = & g_model.telemetrySensors[s_currIdx];
 
-  SUBMENU(STR_MENUSENSOR, SENSOR_FIELD_MAX, { 0, 0, sensor->type == TELEM_TYPE_CALCULATED ? (uint8_t)0 : (uint8_t)1, SENSOR_UNIT_ROWS, SENSOR_PREC_ROWS, SENSOR_PARAM1_ROWS, SENSOR_PARAM2_ROWS, SENSOR_PARAM3_ROWS, SENSOR_PARAM4_ROWS, SENSOR_AUTOOFFSET_ROWS, SENSOR_ONLYPOS_ROWS, SENSOR_FILTER_ROWS, SENSOR_PERSISTENT_ROWS, 0 });
+  SUBMENU(STR_MENUSENSOR, SENSOR_FIELD_MAX, { 0, 0, sensor->type == TELEM_TYPE_CALCULATED ? (uint8_t)0 : (uint8_t)1, SENSOR_UNIT_ROWS, SENSOR_PREC_ROWS, SENSOR_PARAM1_ROWS, SENSOR_PARAM2_ROWS, SENSOR_PARAM3_ROWS, SENSOR_PARAM4_ROWS, SENSOR_AUTOOFFSET_ROWS, SENSOR_ONLYPOS_ROWS, SENSOR_FILTER_ROWS, SENSOR_PERSISTENT_ROWS, 0, 0 });
   lcd_outdezAtt(PSIZE(TR_MENUSENSOR)*FW+1, 0, s_currIdx+1, INVERS|LEFT);
 
   putsTelemetryChannelValue(SENSOR_2ND_COLUMN, 0, s_currIdx, getValue(MIXSRC_FIRST_TELEM+3*s_currIdx), LEFT);
@@ -266,13 +267,17 @@ void menuModelSensor(uint8_t event)
           if (attr) {
             switch (m_posHorz) {
               case 0:
-                sensor->id = checkIncDec(event, sensor->id, 0x0000, 0xffff, INCDEC_REP10|NO_INCDEC_MARKS);
+                sensor->id = checkIncDec(event, sensor->id, 0x0000, 0xffff, EE_MODEL|INCDEC_REP10|NO_INCDEC_MARKS);
                 break;
 
               case 1:
                 CHECK_INCDEC_MODELVAR_ZERO(event, sensor->instance, 0xff);
                 break;
             }
+            if (checkIncDec_Ret) {
+              // the index is rebuilt from the stored id and instance
+              INVALIDATE_TELEMETRY_INDEX();
+            }
           }
         }
         else {
@@ -291,6 +296,10 @@ void menuModelSensor(uint8_t event)
               sensor->unit = UNIT_MAH;
               sensor->prec = 0;
             }
+            else if (sensor->formula == TELEM_FORMULA_BEARING) {
+              sensor->unit = UNIT_DEGREE;
+              sensor->prec = 0;
+            }
           }
         }
         break;
@@ -327,7 +336,7 @@ void menuModelSensor(uint8_t event)
             }
             break;
           }
-          else if (sensor->formula == TELEM_FORMULA_DIST) {
+          else if (sensor->formula == TELEM_FORMULA_DIST || sensor->formula == TELEM_FORMULA_BEARING) {
             lcd_putsLeft(y, STR_GPSSENSOR);
             putsMixerSource(SENSOR_2ND_COLUMN, y, sensor->dist.gps ? MIXSRC_FIRST_TELEM+3*(sensor->dist.gps-1) : 0, attr);
             if (attr) {
@@ -444,6 +453,13 @@ void menuModelSensor(uint8_t event)
         }
         break;
 
+      case SENSOR_FIELD_HISTORY:
+        ON_OFF_MENU_ITEM(sensor->history, SENSOR_2ND_COLUMN, y, STR_HISTORY, attr, event);
+        if (sensor->history) {
+          drawTelemetryHistory(SENSOR_3RD_COLUMN, y, LCD_W-SENSOR_3RD_COLUMN-1, FH-1, s_currIdx, TELEMETRY_HISTORY_1S);
+        }
+        break;
+
     }
   }
 }
@@ -313,6 +313,7 @@ int checkIncDec(unsigned int event, int val, int i_min, int i_max, unsigned int
       if (checkIncDecSelection != MIXSRC_MAX)
         s_editMode = EDIT_MODIFY_FIELD;
       checkIncDecSelection = 0;
+      eeDirty(i_flags & (EE_GENERAL|EE_MODEL));
     }
   }
   else if (i_flags & INCDEC_SWITCH) {
@@ -338,6 +339,7 @@ int checkIncDec(unsigned int event, int val, int i_min, int i_max, unsigned int
       newval = (checkIncDecSelection == SWSRC_INVERT ? -newval : checkIncDecSelection);
       s_editMode = EDIT_MODIFY_FIELD;
       checkIncDecSelection = 0;
+      eeDirty(i_flags & (EE_GENERAL|EE_MODEL));
     }
   }
   return newval;
@@ -44,7 +44,7 @@ void menuStatisticsView(uint8_t event)
   switch(event)
   {
     case EVT_KEY_FIRST(KEY_UP):
-      chainMenu(menuStatisticsDebug);
+      chainMenu(menuStatisticsAudio);
       break;
 
     case EVT_KEY_LONG(KEY_MENU):
@@ -95,11 +95,13 @@ void menuStatisticsView(uint8_t event)
 }
 
 #define MENU_DEBUG_COL1_OFS   (11*FW-2)
-#define MENU_DEBUG_Y_MIXMAX   (2*FH-3)
-#define MENU_DEBUG_Y_LUA      (3*FH-2)
-#define MENU_DEBUG_Y_FREE_RAM (4*FH-1)
-#define MENU_DEBUG_Y_USB      (5*FH)
-#define MENU_DEBUG_Y_RTOS     (6*FH)
+#define MENU_DEBUG_Y_MIXMAX   (1*FH+2)
+#define MENU_DEBUG_Y_LUA      (2*FH+2)
+#define MENU_DEBUG_Y_FREE_RAM (3*FH+2)
+#define MENU_DEBUG_Y_LOGS     (4*FH+2)
+#define MENU_DEBUG_Y_USB      (5*FH+2)
+#define MENU_DEBUG_Y_AUDIO    (5*FH+2) // shared with the USB serial debug
+#define MENU_DEBUG_Y_RTOS     (6*FH+1)
 
 #if defined(USB_SERIAL)
   extern uint16_t usbWraps;
@@ -136,6 +138,16 @@ void menuStatisticsDebug(uint8_t event)
       maxLuaDuration = 0;
 #endif
       maxMixerDuration  = 0;
+      RESET_MIXER_FAST_PATH_STATS();
+#if defined(FRSKY)
+      telemetryFifo.resetStats();
+#endif
+#if defined(SDCARD)
+      logsDroppedRows = 0;
+      logsMaxFlushLatency = 0;
+      logsQueueMaxDepth = 0;
+      audioCache.resetStats();
+#endif
       AUDIO_KEYPAD_UP();
       break;
 
@@ -146,7 +158,11 @@ void menuStatisticsDebug(uint8_t event)
 #endif
 
     case EVT_KEY_FIRST(KEY_DOWN):
-      chainMenu(menuStatisticsView);
+#if defined(MIXER_PROFILER)
+      chainMenu(menuStatisticsProfiler);
+#else
+      chainMenu(menuStatisticsAudio);
+#endif
       break;
     case EVT_KEY_FIRST(KEY_EXIT):
       chainMenu(menuMainView);
@@ -165,6 +181,25 @@ void menuStatisticsDebug(uint8_t event)
   lcd_putsLeft(MENU_DEBUG_Y_FREE_RAM, "Free Mem");
   lcd_outdezAtt(MENU_DEBUG_COL1_OFS, MENU_DEBUG_Y_FREE_RAM, availableMemory(), LEFT);
   lcd_puts(lcdLastPos, MENU_DEBUG_Y_FREE_RAM, "b");
+#if defined(FRSKY)
+  lcd_putsAtt(lcdLastPos+2, MENU_DEBUG_Y_FREE_RAM+1, "[Tlm]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_FREE_RAM, telemetryFifo.getHighWaterMark(), LEFT);
+  lcd_putc(lcdLastPos, MENU_DEBUG_Y_FREE_RAM, '/');
+  lcd_outdezAtt(lcdLastPos+1, MENU_DEBUG_Y_FREE_RAM, telemetryFifo.getOverflows(), LEFT);
+#endif
+
+#if defined(SDCARD)
+  lcd_putsLeft(MENU_DEBUG_Y_LOGS, "SD Logs");
+  lcd_putsAtt(MENU_DEBUG_COL1_OFS, MENU_DEBUG_Y_LOGS+1, "[Queue]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_LOGS, logsQueueDepth(), LEFT);
+  lcd_putc(lcdLastPos, MENU_DEBUG_Y_LOGS, '/');
+  lcd_outdezAtt(lcdLastPos+1, MENU_DEBUG_Y_LOGS, logsQueueMaxDepth, LEFT);
+  lcd_putsAtt(lcdLastPos+2, MENU_DEBUG_Y_LOGS+1, "[Drop]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_LOGS, logsDroppedRows, LEFT);
+  lcd_putsAtt(lcdLastPos+2, MENU_DEBUG_Y_LOGS+1, "[Flush]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_LOGS, 10*logsMaxFlushLatency, LEFT);
+  lcd_puts(lcdLastPos, MENU_DEBUG_Y_LOGS, "ms");
+#endif
 
 #if defined(LUA)
   lcd_putsLeft(MENU_DEBUG_Y_LUA, "Lua scripts");
@@ -177,6 +212,22 @@ void menuStatisticsDebug(uint8_t event)
   lcd_putsLeft(MENU_DEBUG_Y_MIXMAX, STR_TMIXMAXMS);
   lcd_outdezAtt(MENU_DEBUG_COL1_OFS, MENU_DEBUG_Y_MIXMAX, DURATION_MS_PREC2(maxMixerDuration), PREC2|LEFT);
   lcd_puts(lcdLastPos, MENU_DEBUG_Y_MIXMAX, "ms");
+  lcd_putsAtt(lcdLastPos+2, MENU_DEBUG_Y_MIXMAX+1, "[LS]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_MIXMAX, logicalSwitchesEvaluated, LEFT);
+  lcd_putsAtt(lcdLastPos+2, MENU_DEBUG_Y_MIXMAX+1, "[FP]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_MIXMAX, mixerCyclesCount ? (uint32_t)((uint64_t)mixerFastPathCount * 100 / mixerCyclesCount) : 0, LEFT);
+  lcd_putc(lcdLastPos, MENU_DEBUG_Y_MIXMAX, '%');
+
+#if defined(SDCARD) && !defined(USB_SERIAL)
+  lcd_putsLeft(MENU_DEBUG_Y_AUDIO, "SD Audio");
+  lcd_putsAtt(MENU_DEBUG_COL1_OFS, MENU_DEBUG_Y_AUDIO+1, "[Hit]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_AUDIO, audioCache.hits, LEFT);
+  lcd_putsAtt(lcdLastPos+2, MENU_DEBUG_Y_AUDIO+1, "[Miss]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_AUDIO, audioCache.misses, LEFT);
+  lcd_putsAtt(lcdLastPos+2, MENU_DEBUG_Y_AUDIO+1, "[Cache]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_AUDIO, audioCache.used(), LEFT);
+  lcd_puts(lcdLastPos, MENU_DEBUG_Y_AUDIO, "b");
+#endif
 
 #if defined(USB_SERIAL)
   lcd_putsLeft(MENU_DEBUG_Y_USB, "Usb");
@@ -194,6 +245,10 @@ void menuStatisticsDebug(uint8_t event)
   lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_RTOS, mixerStack.available(), UNSIGN|LEFT);
   lcd_putsAtt(lcdLastPos+2, MENU_DEBUG_Y_RTOS+1, "[A]", SMLSIZE);
   lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_RTOS, audioStack.available(), UNSIGN|LEFT);
+#if defined(SDCARD)
+  lcd_putsAtt(lcdLastPos+2, MENU_DEBUG_Y_RTOS+1, "[L]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_RTOS, logsStack.available(), UNSIGN|LEFT);
+#endif
   lcd_putsAtt(lcdLastPos+2, MENU_DEBUG_Y_RTOS+1, "[I]", SMLSIZE);
   lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_RTOS, stackAvailable(), UNSIGN|LEFT);
 
@@ -202,6 +257,136 @@ void menuStatisticsDebug(uint8_t event)
 }
 
 
+#if defined(MIXER_PROFILER)
+#define MENU_PROFILER_COL_MIN    (11*FW)
+#define MENU_PROFILER_COL_AVG    (16*FW)
+#define MENU_PROFILER_COL_MAX    (21*FW)
+#define MENU_PROFILER_COL_HIST   (22*FW)
+#define MENU_PROFILER_HIST_STEP  4
+#define MENU_PROFILER_ROWS       (LCD_LINES-2)
+
+void menuStatisticsProfiler(uint8_t event)
+{
+  static uint8_t firstStage = 0;
+
+  TITLE("MIXER PROFILER");
+
+  switch(event)
+  {
+    case EVT_KEY_FIRST(KEY_ENTER):
+      mixerProfilerReset();
+      AUDIO_KEYPAD_UP();
+      break;
+    case EVT_KEY_FIRST(KEY_PAGE):
+      firstStage = (firstStage < PROFILER_STAGES_COUNT-MENU_PROFILER_ROWS ? firstStage+1 : 0);
+      break;
+    case EVT_KEY_FIRST(KEY_UP):
+      chainMenu(menuStatisticsDebug);
+      break;
+    case EVT_KEY_FIRST(KEY_DOWN):
+      chainMenu(menuStatisticsAudio);
+      break;
+    case EVT_KEY_FIRST(KEY_EXIT):
+      chainMenu(menuMainView);
+      break;
+  }
+
+  lcd_puts(MENU_PROFILER_COL_MIN-3*FW, FH, "Min");
+  lcd_puts(MENU_PROFILER_COL_AVG-3*FW, FH, "Avg");
+  lcd_puts(MENU_PROFILER_COL_MAX-3*FW, FH, "Max");
+  lcd_puts(MENU_PROFILER_COL_HIST+2, FH, "[us]");
+  lcd_puts(LCD_W-5*FW, FH, "Count");
+
+  // only the stages which have been executed are displayed, [PAGE] scrolls through them
+  uint8_t row = 0;
+  uint8_t skipped = 0;
+  for (uint8_t i=0; i<PROFILER_STAGES_COUNT && row<MENU_PROFILER_ROWS; i++) {
+    const MixerProfilerStage & stage = mixerProfilerStages[i];
+    if (stage.count == 0 || skipped++ < firstStage) continue;
+    coord_t y = (2+row)*FH;
+    lcd_puts(0, y, mixerProfilerStageNames[i]);
+    lcd_outdezAtt(MENU_PROFILER_COL_MIN, y, PROFILER_DURATION_US(stage.min));
+    lcd_outdezAtt(MENU_PROFILER_COL_AVG, y, PROFILER_DURATION_US(stage.total / stage.count));
+    lcd_outdezAtt(MENU_PROFILER_COL_MAX, y, PROFILER_DURATION_US(stage.max));
+    uint32_t highest = 0;
+    for (uint8_t j=0; j<PROFILER_HISTOGRAM_BUCKETS; j++) {
+      highest = max(highest, stage.histogram[j]);
+    }
+    for (uint8_t j=0; j<PROFILER_HISTOGRAM_BUCKETS; j++) {
+      if (stage.histogram[j]) {
+        scoord_t h = 1 + (stage.histogram[j] * (FH-2)) / highest;
+        for (uint8_t k=0; k<MENU_PROFILER_HIST_STEP-1; k++) {
+          lcd_vline(MENU_PROFILER_COL_HIST+2+j*MENU_PROFILER_HIST_STEP+k, y+FH-1-h, h);
+        }
+      }
+    }
+    lcd_outdezAtt(LCD_W, y, stage.count);
+    row++;
+  }
+}
+#endif
+
+#define MENU_AUDIO_COL_COUNT    (14*FW)
+#define MENU_AUDIO_COL_MAX      (20*FW)
+#define MENU_AUDIO_COL_HIST     (21*FW)
+#define MENU_AUDIO_HIST_STEP    4
+
+void menuStatisticsAudio(uint8_t event)
+{
+  TITLE("AUDIO LATENCY");
+
+  switch(event)
+  {
+    case EVT_KEY_FIRST(KEY_ENTER):
+      audioQueue.resetStats();
+      AUDIO_KEYPAD_UP();
+      break;
+    case EVT_KEY_FIRST(KEY_UP):
+#if defined(MIXER_PROFILER)
+      chainMenu(menuStatisticsProfiler);
+#else
+      chainMenu(menuStatisticsDebug);
+#endif
+      break;
+    case EVT_KEY_FIRST(KEY_DOWN):
+      chainMenu(menuStatisticsView);
+      break;
+    case EVT_KEY_FIRST(KEY_EXIT):
+      chainMenu(menuMainView);
+      break;
+  }
+
+  lcd_putsAtt(LCD_W-9*FW, 0, "Undr", SMLSIZE);
+  lcd_outdezAtt(LCD_W, 0, audioQueue.underruns);
+
+  lcd_puts(MENU_AUDIO_COL_COUNT-5*FW, FH, "Count");
+  lcd_puts(MENU_AUDIO_COL_MAX-3*FW, FH, "Max");
+  lcd_puts(MENU_AUDIO_COL_HIST+2, FH, "<1ms..>64ms");
+
+  // the time from the queue to the first mixed buffer, then to the DAC
+  for (uint8_t i=0; i<2*AUDIO_LATENCY_CONTEXTS; i++) {
+    const AudioLatencyStats & stats = audioQueue.latencies[i/2];
+    const AudioLatencyHistogram & histogram = (i & 1) ? stats.dac : stats.fill;
+    coord_t y = (2+i)*FH;
+    lcd_puts(0, y, audioLatencyContextNames[i/2]);
+    lcd_puts(5*FW, y, (i & 1) ? "DAC" : "Fill");
+    lcd_outdezAtt(MENU_AUDIO_COL_COUNT, y, histogram.count);
+    lcd_outdezAtt(MENU_AUDIO_COL_MAX, y, histogram.max/100, PREC1);
+    uint32_t highest = 0;
+    for (uint8_t j=0; j<AUDIO_LATENCY_BUCKETS; j++) {
+      highest = max(highest, histogram.buckets[j]);
+    }
+    for (uint8_t j=0; j<AUDIO_LATENCY_BUCKETS; j++) {
+      if (histogram.buckets[j]) {
+        scoord_t h = 1 + (histogram.buckets[j] * (FH-2)) / highest;
+        for (uint8_t k=0; k<MENU_AUDIO_HIST_STEP-1; k++) {
+          lcd_vline(MENU_AUDIO_COL_HIST+2+j*MENU_AUDIO_HIST_STEP+k, y+FH-1-h, h);
+        }
+      }
+    }
+  }
+}
+
 #if defined(DEBUG_TRACE_BUFFER)
 #include "stamp-opentx.h"
 
@@ -135,6 +135,31 @@ void drawGauge(coord_t x, coord_t y, coord_t w, coord_t h, int32_t val, int32_t
   }
 }
 
+// one column per history bucket, from its min to its max, the newest on the right
+void drawTelemetryHistory(coord_t x, coord_t y, coord_t w, coord_t h, uint8_t index, uint8_t resolution)
+{
+  static TelemetryHistoryBucket buckets[TELEMETRY_HISTORY_BUCKETS];
+  uint8_t count = readTelemetryHistory(index, resolution, buckets, min<coord_t>(w, DIM(buckets)));
+  if (count == 0) {
+    return;
+  }
+
+  int32_t vmin = buckets[0].min;
+  int32_t vmax = buckets[0].max;
+  for (int i=1; i<count; i++) {
+    if (buckets[i].min < vmin) vmin = buckets[i].min;
+    if (buckets[i].max > vmax) vmax = buckets[i].max;
+  }
+  int32_t range = max<int32_t>(1, vmax - vmin);
+
+  x += w - count;
+  for (int i=0; i<count; i++) {
+    coord_t top = y + h - 1 - (buckets[i].max - vmin) * (h - 1) / range;
+    coord_t bottom = y + h - 1 - (buckets[i].min - vmin) * (h - 1) / range;
+    lcd_vline(x+i, top, bottom - top + 1);
+  }
+}
+
 void title(const pm_char * s)
 {
   lcd_putsAtt(0, 0, s, INVERS);
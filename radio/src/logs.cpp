@@ -36,6 +36,7 @@
 
 #include "opentx.h"
 #include "ff.h"
+#include <stdarg.h>
 
 FIL g_oLogFile = {0};
 const pm_char * g_logError = NULL;
@@ -49,6 +50,132 @@ uint8_t logDelay;
 
 #define get3PosState(sw) (switchState(SW_ ## sw ## 0) ? -1 : (switchState(SW_ ## sw ## 2) ? 1 : 0))
 
+#if defined(CPUARM)
+uint8_t logsFormat = LOGS_FORMAT_CSV;
+uint8_t openedLogsFormat;
+
+// The rows are staged in logsBuffer, indexed by their offset in the file: the buffer
+// sectors match the file sectors, so that f_write is given whole sectors which FatFs
+// writes directly to the card, without going through its one-sector window.
+// The buffer is a single producer / single consumer queue: perMain() formats the rows
+// and moves the head, the logs task writes them to the file and moves the tail
+uint8_t logsBuffer[LOGS_BUFFER_SIZE] __DMA;
+volatile uint32_t logsBufferHead;   // end of the last complete row
+volatile uint32_t logsBufferTail;   // end of the data already written to the file
+uint32_t logsRowPos;                // end of the row being formatted
+bool logsRowOverflow;
+tmr10ms_t logsLastSync;
+uint32_t logsDroppedRows = 0;
+tmr10ms_t logsMaxFlushLatency = 0;
+uint32_t logsQueueMaxDepth = 0;
+
+// The logs file is only accessed by the logs task, perMain() drives it through logsState
+volatile uint8_t logsState = LOGS_CLOSED;
+const pm_char * volatile logsError = NULL;
+
+#define LOGS_PRINTF(...) logsPrintf(__VA_ARGS__)
+
+void logsBufferReset()
+{
+  logsRowPos = f_tell(&g_oLogFile);
+  logsRowOverflow = false;
+  logsLastSync = get_tmr10ms();
+  FIFO_BARRIER();
+  logsBufferHead = logsBufferTail = logsRowPos;
+}
+
+void logsWrite(const void * data, uint32_t size)
+{
+  if (logsRowOverflow || logsRowPos + size - logsBufferTail > LOGS_BUFFER_SIZE) {
+    logsRowOverflow = true;
+    return;
+  }
+
+  const uint8_t * src = (const uint8_t *)data;
+  while (size > 0) {
+    uint32_t index = logsRowPos % LOGS_BUFFER_SIZE;
+    uint32_t count = min<uint32_t>(size, LOGS_BUFFER_SIZE - index);
+    memcpy(&logsBuffer[index], src, count);
+    src += count;
+    size -= count;
+    logsRowPos += count;
+  }
+}
+
+int logsPrintf(const char * format, ...)
+{
+  char tmp[LOGS_PRINTF_BUFFER_SIZE];
+  va_list arglist;
+  va_start(arglist, format);
+  int len = vsnprintf(tmp, sizeof(tmp), format, arglist);
+  va_end(arglist);
+  if (len < 0 || len >= (int)sizeof(tmp)) {
+    logsRowOverflow = true;
+    return -1;
+  }
+  logsWrite(tmp, len);
+  return len;
+}
+
+bool logsCommitRow()
+{
+  if (logsRowOverflow) {
+    // the buffer is full (the card is too slow), the row is dropped
+    logsDroppedRows++;
+    logsRowPos = logsBufferHead;
+    logsRowOverflow = false;
+    return false;
+  }
+  else {
+    FIFO_BARRIER();
+    logsBufferHead = logsRowPos;
+    uint32_t depth = logsRowPos - logsBufferTail;
+    if (depth > logsQueueMaxDepth) {
+      logsQueueMaxDepth = depth;
+    }
+    return true;
+  }
+}
+
+uint32_t logsQueueDepth()
+{
+  return logsBufferHead - logsBufferTail;
+}
+
+int logsFlush(bool all)
+{
+  tmr10ms_t start = get_tmr10ms();
+  uint32_t end = (all ? logsBufferHead : logsBufferHead & ~(uint32_t)(LOGS_SECTOR_SIZE-1));
+
+  while (logsBufferTail < end) {
+    uint32_t index = logsBufferTail % LOGS_BUFFER_SIZE;
+    uint32_t size = min<uint32_t>(end - logsBufferTail, LOGS_BUFFER_SIZE - index);
+    UINT written;
+    if (f_write(&g_oLogFile, &logsBuffer[index], size, &written) != FR_OK || written != size) {
+      return -1;
+    }
+    FIFO_BARRIER();
+    logsBufferTail += size;
+  }
+
+  if (!all && (tmr10ms_t)(get_tmr10ms() - logsLastSync) >= LOGS_SYNC_PERIOD*100) {
+    logsLastSync = get_tmr10ms();
+    if (f_sync(&g_oLogFile) != FR_OK) {
+      return -1;
+    }
+  }
+
+  tmr10ms_t latency = get_tmr10ms() - start;
+  if (latency > logsMaxFlushLatency) {
+    logsMaxFlushLatency = latency;
+  }
+
+  return 0;
+}
+#else
+#define LOGS_PRINTF(...) f_printf(&g_oLogFile, __VA_ARGS__)
+#endif
+
 const pm_char *openLogs()
 {
   // Determine and set log file filename
@@ -104,13 +231,31 @@ const pm_char *openLogs()
   tmp = strAppendDate(&filename[len]);
 #endif
 
+#if defined(CPUARM)
+  strcpy_P(tmp, logsFormat == LOGS_FORMAT_BINARY ? LOGS_BINARY_EXT : STR_LOGS_EXT);
+#else
   strcpy_P(tmp, STR_LOGS_EXT);
+#endif
 
   result = f_open(&g_oLogFile, filename, FA_OPEN_ALWAYS | FA_WRITE);
   if (result != FR_OK) {
     return SDCARD_ERROR(result);
   }
 
+#if defined(CPUARM)
+  openedLogsFormat = logsFormat;
+  if (logsFormat == LOGS_FORMAT_BINARY) {
+    // each session is appended with its own header
+    result = f_lseek(&g_oLogFile, f_size(&g_oLogFile));
+    if (result != FR_OK) {
+      return SDCARD_ERROR(result);
+    }
+    writeBinaryHeader();
+    logsBufferReset();
+    return NULL;
+  }
+#endif
+
   if (f_size(&g_oLogFile) == 0) {
     writeHeader();
   }
@@ -121,11 +266,83 @@ const pm_char *openLogs()
     }
   }
 
+#if defined(CPUARM)
+  logsBufferReset();
+#endif
+
   return NULL;
 }
 
 tmr10ms_t lastLogTime = 0;
 
+#if defined(CPUARM)
+void closeLogsFile()
+{
+  logsFlush(true);
+
+  if (f_close(&g_oLogFile) != FR_OK) {
+    // close failed, forget file
+    g_oLogFile.fs = 0;
+  }
+}
+
+void logsWakeup()
+{
+  switch (logsState) {
+    case LOGS_OPENING:
+    {
+      const pm_char * result = openLogs();
+      if (result != NULL) {
+        if (g_oLogFile.fs) {
+          f_close(&g_oLogFile);
+          g_oLogFile.fs = 0;
+        }
+        logsError = result;
+        logsState = LOGS_CLOSED;
+      }
+      else {
+        logsState = LOGS_OPENED;
+      }
+      break;
+    }
+
+    case LOGS_OPENED:
+      if (logsFlush(false) < 0) {
+        logsError = STR_SDCARD_ERROR;
+        closeLogsFile();
+        logsState = LOGS_CLOSED;
+      }
+      break;
+
+    case LOGS_CLOSING:
+      closeLogsFile();
+      logsState = LOGS_CLOSED;
+      break;
+  }
+}
+
+// Waits until the logs task has closed the file (at most 1s): the callers reuse
+// g_oLogFile or unmount the card afterwards. If the task is still blocked on the
+// card after that, the file is forgotten, as when the close fails
+void closeLogs()
+{
+  for (int i=0; i<100 && logsState != LOGS_CLOSED; i++) {
+    if (logsState == LOGS_OPENED) {
+      logsState = LOGS_CLOSING;
+    }
+#if defined(SIMU)
+    logsWakeup();
+#else
+    CoTickDelay(5);  // 10ms
+#endif
+  }
+  if (logsState != LOGS_CLOSED) {
+    g_oLogFile.fs = 0;
+    logsState = LOGS_CLOSED;
+  }
+  lastLogTime = 0;
+}
+#else
 void closeLogs()
 {
   if (f_close(&g_oLogFile) != FR_OK) {
@@ -134,6 +351,7 @@ void closeLogs()
   }
   lastLogTime = 0;
 }
+#endif
 
 #if !defined(CPUARM)
 getvalue_t getConvertedTelemetryValue(getvalue_t val, uint8_t unit)
@@ -203,15 +421,250 @@ void writeHeader()
 #endif
 }
 
+#if defined(CPUARM)
+struct LogsBinaryColumn {
+  uint8_t kind;
+  uint8_t index;
+};
+
+LogsBinaryColumn logsColumns[LOGS_BINARY_MAX_FIELDS];
+uint8_t logsColumnsCount;
+int32_t logsPreviousValues[LOGS_BINARY_MAX_FIELDS];
+uint8_t logsRowsSinceKeyframe;
+
+#if defined(PCBTARANIS)
+const char * const logsSwitchesNames[] = { "SA", "SB", "SC", "SD", "SE", "SF", "SG", "SH" };
+#else
+const char * const logsSwitchesNames[] = { "THR", "RUD", "ELE", "3POS", "AIL", "GEA", "TRN" };
+#endif
+
+void getLogsSwitchesStates(int8_t * states)
+{
+#if defined(PCBTARANIS)
+  states[0] = get3PosState(SA);
+  states[1] = get3PosState(SB);
+  states[2] = get3PosState(SC);
+  states[3] = get3PosState(SD);
+  states[4] = get3PosState(SE);
+  states[5] = get2PosState(SF);
+  states[6] = get3PosState(SG);
+  states[7] = get2PosState(SH);
+#else
+  states[0] = get2PosState(THR);
+  states[1] = get2PosState(RUD);
+  states[2] = get2PosState(ELE);
+  states[3] = get3PosState(ID);
+  states[4] = get2PosState(AIL);
+  states[5] = get2PosState(GEA);
+  states[6] = get2PosState(TRN);
+#endif
+}
+
+void addLogsColumn(uint8_t kind, uint8_t index, const char * name, const char * unit=NULL, uint8_t prec=0)
+{
+  if (logsColumnsCount < LOGS_BINARY_MAX_FIELDS) {
+    LogsBinaryField field;
+    UINT written;
+    memclear(&field, sizeof(field));
+    strncpy(field.name, name, sizeof(field.name));
+    if (unit) {
+      strncpy(field.unit, unit, sizeof(field.unit));
+    }
+    field.prec = prec;
+    field.kind = kind;
+    f_write(&g_oLogFile, &field, sizeof(field), &written);
+    logsColumns[logsColumnsCount].kind = kind;
+    logsColumns[logsColumnsCount].index = index;
+    logsColumnsCount++;
+  }
+}
+
+void writeBinaryHeader()
+{
+  LogsBinaryHeader header;
+  UINT written;
+  char name[TELEM_LABEL_LEN+1];
+  char unit[4];
+
+  logsColumnsCount = 0;
+  for (int i=0; i<MAX_SENSORS; i++) {
+    TelemetrySensor & sensor = g_model.telemetrySensors[i];
+    if (sensor.logs && sensor.unit != UNIT_DATETIME) {
+      logsColumnsCount += (sensor.unit == UNIT_GPS ? 2 : 1);
+    }
+  }
+  logsColumnsCount = min<uint8_t>(1 + logsColumnsCount + NUM_STICKS+NUM_POTS + DIM(logsSwitchesNames), LOGS_BINARY_MAX_FIELDS);
+
+  memcpy(header.magic, LOGS_BINARY_MAGIC, sizeof(header.magic));
+  header.version = LOGS_BINARY_VERSION;
+  header.fieldsCount = logsColumnsCount;
+  header.period = logDelay * 10;
+#if defined(RTCLOCK)
+  header.startTime = g_rtcTime;
+#else
+  header.startTime = 0;
+#endif
+  f_write(&g_oLogFile, &header, sizeof(header), &written);
+
+  logsColumnsCount = 0;
+  addLogsColumn(LOGS_FIELD_TIME, 0, "Time");
+
+  for (int i=0; i<MAX_SENSORS; i++) {
+    TelemetrySensor & sensor = g_model.telemetrySensors[i];
+    if (sensor.logs && sensor.unit != UNIT_DATETIME) {
+      memclear(name, sizeof(name));
+      zchar2str(name, sensor.label, TELEM_LABEL_LEN);
+      if (sensor.unit == UNIT_GPS) {
+        addLogsColumn(LOGS_FIELD_LATITUDE, i, name);
+        addLogsColumn(LOGS_FIELD_LONGITUDE, i, name);
+      }
+      else {
+        memclear(unit, sizeof(unit));
+        if (sensor.unit != UNIT_RAW) {
+          strncpy(unit, STR_VTELEMUNIT+1+3*sensor.unit, 3);
+        }
+        addLogsColumn(LOGS_FIELD_SENSOR, i, name, unit, sensor.prec);
+      }
+    }
+  }
+
+  for (uint8_t i=0; i<NUM_STICKS+NUM_POTS; i++) {
+    memclear(name, sizeof(name));
+    strncpy(name, STR_VSRCRAW + (i+1) * STR_VSRCRAW[0] + 2, min<uint8_t>(STR_VSRCRAW[0]-1, sizeof(name)-1));
+    addLogsColumn(LOGS_FIELD_STICK, i, name);
+  }
+
+  for (uint8_t i=0; i<DIM(logsSwitchesNames); i++) {
+    addLogsColumn(LOGS_FIELD_SWITCH, i, logsSwitchesNames[i]);
+  }
+
+  // the first record is a keyframe
+  logsRowsSinceKeyframe = LOGS_BINARY_KEYFRAME_PERIOD;
+}
+
+int32_t getLogsColumnValue(const LogsBinaryColumn & column, tmr10ms_t tmr10ms, const int8_t * switches)
+{
+  switch (column.kind) {
+    case LOGS_FIELD_TIME:
+      return tmr10ms;
+
+    case LOGS_FIELD_SENSOR:
+      return telemetryItems[column.index].value;
+
+    case LOGS_FIELD_LATITUDE:
+    case LOGS_FIELD_LONGITUDE:
+    {
+      TelemetryItem & telemetryItem = telemetryItems[column.index];
+      if (!telemetryItem.gps.longitudeEW || !telemetryItem.gps.latitudeNS) {
+        return 0;
+      }
+      uint32_t latitude, longitude;
+      telemetryItem.gps.extractLatitudeLongitude(&latitude, &longitude);
+      if (column.kind == LOGS_FIELD_LATITUDE)
+        return (telemetryItem.gps.latitudeNS == 'S' ? -(int32_t)latitude : (int32_t)latitude);
+      else
+        return (telemetryItem.gps.longitudeEW == 'W' ? -(int32_t)longitude : (int32_t)longitude);
+    }
+
+    case LOGS_FIELD_STICK:
+      return calibratedStick[column.index];
+
+    case LOGS_FIELD_SWITCH:
+      return switches[column.index];
+
+    default:
+      return 0;
+  }
+}
+
+void writeBinaryLogsRow(tmr10ms_t tmr10ms)
+{
+  static uint8_t record[1 + sizeof(int32_t)*LOGS_BINARY_MAX_FIELDS];
+  static int32_t values[LOGS_BINARY_MAX_FIELDS];
+  int8_t switches[DIM(logsSwitchesNames)];
+
+  getLogsSwitchesStates(switches);
+
+  bool keyframe = (++logsRowsSinceKeyframe >= LOGS_BINARY_KEYFRAME_PERIOD);
+  for (int i=0; i<logsColumnsCount; i++) {
+    values[i] = getLogsColumnValue(logsColumns[i], tmr10ms, switches);
+    int32_t delta = values[i] - logsPreviousValues[i];
+    if (delta < -32768 || delta > 32767) {
+      keyframe = true;
+    }
+  }
+
+  uint8_t * pos = record;
+  if (keyframe) {
+    logsRowsSinceKeyframe = 0;
+    *pos++ = LOGS_BINARY_KEYFRAME;
+    for (int i=0; i<logsColumnsCount; i++) {
+      int32_t value = values[i];
+      memcpy(pos, &value, sizeof(value));
+      pos += sizeof(value);
+    }
+  }
+  else {
+    *pos++ = LOGS_BINARY_DELTA;
+    for (int i=0; i<logsColumnsCount; i++) {
+      int16_t delta = values[i] - logsPreviousValues[i];
+      memcpy(pos, &delta, sizeof(delta));
+      pos += sizeof(delta);
+    }
+  }
+  memcpy(logsPreviousValues, values, sizeof(int32_t)*logsColumnsCount);
+
+  logsWrite(record, pos - record);
+  if (!logsCommitRow()) {
+    // the next record can't be a delta from a dropped one
+    logsRowsSinceKeyframe = LOGS_BINARY_KEYFRAME_PERIOD;
+  }
+}
+#endif
+
 void writeLogs()
 {
   static const pm_char * error_displayed = NULL;
 
+#if defined(CPUARM)
+#if defined(SIMU)
+  // no logs task in the simulator
+  logsWakeup();
+#endif
+
+  const pm_char * error = logsError;
+  if (error) {
+    logsError = NULL;
+    if (error != error_displayed) {
+      error_displayed = error;
+      POPUP_WARNING(error);
+    }
+  }
+#endif
+
   if (isFunctionActive(FUNCTION_LOGS) && logDelay > 0) {
     tmr10ms_t tmr10ms = get_tmr10ms();
     if (lastLogTime == 0 || (tmr10ms_t)(tmr10ms - lastLogTime) >= (tmr10ms_t)logDelay*10) {
       lastLogTime = tmr10ms;
 
+#if defined(CPUARM)
+      if (logsState == LOGS_OPENED && openedLogsFormat != logsFormat) {
+        logsState = LOGS_CLOSING;
+      }
+
+      if (logsState != LOGS_OPENED) {
+        // the file will be (re)opened by the logs task
+        if (logsState == LOGS_CLOSED) {
+          logsState = LOGS_OPENING;
+        }
+        return;
+      }
+
+      if (openedLogsFormat == LOGS_FORMAT_BINARY) {
+        writeBinaryLogsRow(tmr10ms);
+        return;
+      }
+#else
       if (!g_oLogFile.fs) {
         const pm_char * result = openLogs();
         if (result != NULL) {
@@ -222,6 +675,7 @@ void writeLogs()
           return;
         }
       }
+#endif
 
 #if defined(RTCLOCK)
       {
@@ -232,25 +686,25 @@ void writeLogs()
           lastRtcTime = g_rtcTime;
           gettime(&utm);
         }
-        f_printf(&g_oLogFile, "%4d-%02d-%02d,%02d:%02d:%02d.%02d0,", utm.tm_year+1900, utm.tm_mon+1, utm.tm_mday, utm.tm_hour, utm.tm_min, utm.tm_sec, g_ms100);
+        LOGS_PRINTF("%4d-%02d-%02d,%02d:%02d:%02d.%02d0,", utm.tm_year+1900, utm.tm_mon+1, utm.tm_mday, utm.tm_hour, utm.tm_min, utm.tm_sec, g_ms100);
       }
 #else
-      f_printf(&g_oLogFile, "%d,", tmr10ms);
+      LOGS_PRINTF("%d,", tmr10ms);
 #endif
 
 #if defined(FRSKY)
 #if !defined(CPUARM)
-      f_printf(&g_oLogFile, "%d,%d,%d,", frskyStreaming, RAW_FRSKY_MINMAX(frskyData.rssi[0]), RAW_FRSKY_MINMAX(frskyData.rssi[1]));
+      LOGS_PRINTF("%d,%d,%d,", frskyStreaming, RAW_FRSKY_MINMAX(frskyData.rssi[0]), RAW_FRSKY_MINMAX(frskyData.rssi[1]));
       for (uint8_t i=0; i<MAX_FRSKY_A_CHANNELS; i++) {
         int16_t converted_value = applyChannelRatio(i, RAW_FRSKY_MINMAX(frskyData.analog[i]));
-        f_printf(&g_oLogFile, "%d.%02d,", converted_value/100, converted_value%100);
+        LOGS_PRINTF("%d.%02d,", converted_value/100, converted_value%100);
       }
 
 #if defined(FRSKY_HUB)
       TELEMETRY_BARO_ALT_PREPARE();
 
       if (IS_USR_PROTO_FRSKY_HUB()) {
-        f_printf(&g_oLogFile, "%4d-%02d-%02d,%02d:%02d:%02d,%03d.%04d%c,%03d.%04d%c,%03d.%02d," TELEMETRY_GPS_SPEED_FORMAT TELEMETRY_GPS_ALT_FORMAT TELEMETRY_BARO_ALT_FORMAT TELEMETRY_VSPEED_FORMAT TELEMETRY_ASPEED_FORMAT "%d,%d,%d,%d," TELEMETRY_CELLS_FORMAT TELEMETRY_CURRENT_FORMAT "%d," TELEMETRY_VFAS_FORMAT "%d,%d,%d,",
+        LOGS_PRINTF("%4d-%02d-%02d,%02d:%02d:%02d,%03d.%04d%c,%03d.%04d%c,%03d.%02d," TELEMETRY_GPS_SPEED_FORMAT TELEMETRY_GPS_ALT_FORMAT TELEMETRY_BARO_ALT_FORMAT TELEMETRY_VSPEED_FORMAT TELEMETRY_ASPEED_FORMAT "%d,%d,%d,%d," TELEMETRY_CELLS_FORMAT TELEMETRY_CURRENT_FORMAT "%d," TELEMETRY_VFAS_FORMAT "%d,%d,%d,",
             frskyData.hub.year+2000,
             frskyData.hub.month,
             frskyData.hub.day,
@@ -286,7 +740,7 @@ void writeLogs()
 
 #if defined(WS_HOW_HIGH)
       if (IS_USR_PROTO_WS_HOW_HIGH()) {
-        f_printf(&g_oLogFile, "%d,", TELEMETRY_RELATIVE_BARO_ALT_BP);
+        LOGS_PRINTF("%d,", TELEMETRY_RELATIVE_BARO_ALT_BP);
       }
 #endif
 #endif
@@ -298,28 +752,28 @@ void writeLogs()
         if (sensor.logs) {
           if (sensor.unit == UNIT_GPS) {
             if (telemetryItem.gps.longitudeEW && telemetryItem.gps.latitudeNS)
-              f_printf(&g_oLogFile, "%03d.%04d%c %03d.%04d%c,", telemetryItem.gps.longitude_bp, telemetryItem.gps.longitude_ap, telemetryItem.gps.longitudeEW, telemetryItem.gps.latitude_bp, telemetryItem.gps.latitude_ap, telemetryItem.gps.latitudeNS);
+              LOGS_PRINTF("%03d.%04d%c %03d.%04d%c,", telemetryItem.gps.longitude_bp, telemetryItem.gps.longitude_ap, telemetryItem.gps.longitudeEW, telemetryItem.gps.latitude_bp, telemetryItem.gps.latitude_ap, telemetryItem.gps.latitudeNS);
             else
-              f_printf(&g_oLogFile, ",");
+              LOGS_PRINTF(",");
           }
           else if (sensor.unit == UNIT_DATETIME) {
             if (telemetryItem.datetime.datestate)
-              f_printf(&g_oLogFile, "%4d-%02d-%02d %02d:%02d:%02d,", telemetryItem.datetime.year, telemetryItem.datetime.month, telemetryItem.datetime.day, telemetryItem.datetime.hour, telemetryItem.datetime.min, telemetryItem.datetime.sec);
+              LOGS_PRINTF("%4d-%02d-%02d %02d:%02d:%02d,", telemetryItem.datetime.year, telemetryItem.datetime.month, telemetryItem.datetime.day, telemetryItem.datetime.hour, telemetryItem.datetime.min, telemetryItem.datetime.sec);
             else
-              f_printf(&g_oLogFile, ",");
+              LOGS_PRINTF(",");
           }
           else if (sensor.prec == 2) {
             div_t qr = div(telemetryItem.value, 100);
-            if (telemetryItem.value < 0) f_printf(&g_oLogFile, "-");
-            f_printf(&g_oLogFile, "%d.%02d,", abs(qr.quot), abs(qr.rem));
+            if (telemetryItem.value < 0) LOGS_PRINTF("-");
+            LOGS_PRINTF("%d.%02d,", abs(qr.quot), abs(qr.rem));
           }
           else if (sensor.prec == 1) {
             div_t qr = div(telemetryItem.value, 10);
-            if (telemetryItem.value < 0) f_printf(&g_oLogFile, "-");
-            f_printf(&g_oLogFile, "%d.%d,", abs(qr.quot), abs(qr.rem));
+            if (telemetryItem.value < 0) LOGS_PRINTF("-");
+            LOGS_PRINTF("%d.%d,", abs(qr.quot), abs(qr.rem));
           }
           else {
-            f_printf(&g_oLogFile, "%d,", telemetryItem.value);
+            LOGS_PRINTF("%d,", telemetryItem.value);
           }
         }
       }
@@ -327,11 +781,11 @@ void writeLogs()
 #endif
 
       for (uint8_t i=0; i<NUM_STICKS+NUM_POTS; i++) {
-        f_printf(&g_oLogFile, "%d,", calibratedStick[i]);
+        LOGS_PRINTF("%d,", calibratedStick[i]);
       }
 
 #if defined(PCBTARANIS)
-      int result = f_printf(&g_oLogFile, "%d,%d,%d,%d,%d,%d,%d,%d\n",
+      int result = LOGS_PRINTF("%d,%d,%d,%d,%d,%d,%d,%d\n",
           get3PosState(SA),
           get3PosState(SB),
           get3PosState(SC),
@@ -341,7 +795,7 @@ void writeLogs()
           get3PosState(SG),
           get2PosState(SH));
 #else
-      int result = f_printf(&g_oLogFile, "%d,%d,%d,%d,%d,%d,%d\n",
+      int result = LOGS_PRINTF("%d,%d,%d,%d,%d,%d,%d\n",
           get2PosState(THR),
           get2PosState(RUD),
           get2PosState(ELE),
@@ -351,18 +805,30 @@ void writeLogs()
           get2PosState(TRN));
 #endif
 
+#if defined(CPUARM)
+      // a row which doesn't fit in the buffer (result < 0) is dropped, the SD errors are reported by the logs task
+      (void)result;
+      logsCommitRow();
+#else
       if (result<0 && !error_displayed) {
         error_displayed = STR_SDCARD_ERROR;
         POPUP_WARNING(STR_SDCARD_ERROR);
         closeLogs();
       }
+#endif
     }
   }
   else {
     error_displayed = NULL;
+#if defined(CPUARM)
+    if (logsState == LOGS_OPENED) {
+      logsState = LOGS_CLOSING;
+    }
+#else
     if (g_oLogFile.fs) {
       closeLogs();
     }
+#endif
   }
 }
 
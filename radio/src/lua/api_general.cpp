@@ -404,6 +404,64 @@ static int luaGetValue(lua_State *L)
   return 1;
 }
 
+/*luadoc
+@function getSensorHistory(source [, resolution])
+
+Returns the recorded history of a telemetry sensor. The history is only
+recorded for the sensors which have the History option enabled.
+
+@param source  can be an identifier (number) (which was obtained by the getFieldInfo())
+or a name (string) of the sensor.
+
+@param resolution (optional) `HISTORY_RAW` for the last received values,
+`HISTORY_1S` (default) or `HISTORY_10S` for the 1s or 10s min/max/avg buckets
+
+@retval nil the sensor has no history
+
+@retval table the samples, oldest first, each of them being a table:
+ * `time` (number) time of the sample (or start of the bucket) in 10ms ticks, same as getTime()
+ * `min` (number) lowest value
+ * `max` (number) highest value
+ * `avg` (number) average value
+
+@status current Introduced in 2.1.0
+*/
+static int luaGetSensorHistory(lua_State *L)
+{
+  int src = 0;
+  if (lua_isnumber(L, 1)) {
+    src = luaL_checkinteger(L, 1);
+  }
+  else {
+    const char *name = luaL_checkstring(L, 1);
+    LuaField field;
+    if (luaFindFieldByName(name, field)) {
+      src = field.id;
+    }
+  }
+  unsigned int resolution = luaL_optunsigned(L, 2, TELEMETRY_HISTORY_1S);
+
+  if (src >= MIXSRC_FIRST_TELEM && src <= MIXSRC_LAST_TELEM) {
+    static TelemetryHistoryBucket buckets[TELEMETRY_HISTORY_BUCKETS];
+    uint8_t count = readTelemetryHistory((src-MIXSRC_FIRST_TELEM) / 3, resolution, buckets, DIM(buckets));
+    if (count > 0) {
+      lua_createtable(L, count, 0);
+      for (int i=0; i<count; i++) {
+        lua_createtable(L, 0, 4);
+        lua_pushtableinteger(L, "time", buckets[i].time);
+        lua_pushtableinteger(L, "min", buckets[i].min);
+        lua_pushtableinteger(L, "max", buckets[i].max);
+        lua_pushtableinteger(L, "avg", buckets[i].avg);
+        lua_rawseti(L, -2, i+1);
+      }
+      return 1;
+    }
+  }
+
+  lua_pushnil(L);
+  return 1;
+}
+
 /*luadoc
 @function playFile(name)
 
@@ -672,6 +730,7 @@ const luaL_Reg opentxLib[] = {
   { "getGeneralSettings", luaGetGeneralSettings },
   { "getValue", luaGetValue },
   { "getFieldInfo", luaGetFieldInfo },
+  { "getSensorHistory", luaGetSensorHistory },
   { "playFile", luaPlayFile },
   { "playNumber", luaPlayNumber },
   { "playDuration", luaPlayDuration },
@@ -699,6 +758,9 @@ const luaR_value_entry opentxConstants[] = {
   { "PREC2", PREC2 },
   { "VALUE", 0 },
   { "SOURCE", 1 },
+  { "HISTORY_RAW", TELEMETRY_HISTORY_RAW },
+  { "HISTORY_1S", TELEMETRY_HISTORY_1S },
+  { "HISTORY_10S", TELEMETRY_HISTORY_10S },
   { "REPLACE", MLTPX_REP },
   { "MIXSRC_FIRST_INPUT", MIXSRC_FIRST_INPUT },
   { "MIXSRC_Rud", MIXSRC_Rud },
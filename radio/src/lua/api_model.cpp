@@ -496,6 +496,7 @@ static int luaModelInsertMix(lua_State *L)
         mix->speedDown = luaL_checkinteger(L, -1);
       }
     }
+    eeDirty(EE_MODEL);
   }
 
   return 0;
@@ -519,6 +520,7 @@ static int luaModelDeleteMix(lua_State *L)
 static int luaModelDeleteMixes(lua_State *L)
 {
   memset(g_model.mixData, 0, sizeof(g_model.mixData));
+  eeDirty(EE_MODEL);
   return 0;
 }
 
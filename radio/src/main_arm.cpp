@@ -194,6 +194,8 @@ void perMain()
     drawStatusLine();
   }
 
+  eeCheckEdited();
+
   lcdRefresh();
 
 #if defined(REV9E) && !defined(SIMU)
@@ -165,15 +165,74 @@ getvalue_t div100_and_round(getvalue_t value)
   return value/100;
 }
 
-#if defined(PCBTARANIS)
-double gpsToDouble(bool neg, int16_t bp, int16_t ap)
-{
-  double result = ap;
-  result /= 10000;
-  result += (bp % 100);
-  result /= 60;
-  result += (bp / 100);
-  return neg?-result:result;
+#if defined(CPUARM)
+uint32_t isqrt64(uint64_t n)
+{
+  uint32_t c = 0x80000000;
+  uint32_t g = 0x80000000;
+
+  for (;;) {
+    if ((uint64_t)g*g > n)
+      g ^= c;
+    c >>= 1;
+    if (c == 0)
+      return g;
+    g |= c;
+  }
+}
+
+#define GPS_Q30                 ((int64_t)1 << 30)
+#define GPS_DM_PER_DEGREE       1111949   // decimeters per degree of latitude
+
+uint32_t gpsLongitudeScale(int32_t latitude)
+{
+  // cos(x) = 1 - x²/2 * (1 - x²/12 * (1 - x²/30 * (1 - x²/56 * (1 - x²/90)))), x in radians Q30
+  // the error is below 1e-5 up to 90 degrees
+  int64_t x = (int64_t)abs(latitude) * 1874033 / 100000;
+  int64_t x2 = (x * x) >> 30;
+  int64_t result = GPS_Q30 - x2 / 90;
+  result = GPS_Q30 - ((x2 * result) >> 30) / 56;
+  result = GPS_Q30 - ((x2 * result) >> 30) / 30;
+  result = GPS_Q30 - ((x2 * result) >> 30) / 12;
+  result = GPS_Q30 - ((x2 * result) >> 30) / 2;
+  return result > 0 ? (result + (1 << 13)) >> 14 : 0;
+}
+
+void gpsGetOffset(int32_t pilotLatitude, int32_t pilotLongitude, uint32_t scale, int32_t latitude, int32_t longitude, int32_t * east, int32_t * north)
+{
+  int32_t dlon = longitude - pilotLongitude;
+  if (dlon > 180000000)
+    dlon -= 360000000;
+  else if (dlon < -180000000)
+    dlon += 360000000;
+  *north = (int64_t)(latitude - pilotLatitude) * GPS_DM_PER_DEGREE / 1000000;
+  *east = (((int64_t)dlon * GPS_DM_PER_DEGREE / 1000000) * scale) >> 16;
+}
+
+uint32_t gpsGetDistance(int32_t east, int32_t north, int32_t height)
+{
+  int64_t up = (int64_t)height * 10;
+  return (isqrt64((int64_t)east*east + (int64_t)north*north + up*up) + 5) / 10;
+}
+
+uint16_t gpsGetBearing(int32_t east, int32_t north)
+{
+  uint32_t x = abs(east);
+  uint32_t y = abs(north);
+  if (x == 0 && y == 0)
+    return 0;
+
+  // atan(r) = 45r + r(1-r)(14.02 + 3.80r) degrees for r in [0, 1], the error is below 0.1 degree
+  uint32_t r = ((uint64_t)min(x, y) << 15) / max(x, y);   // Q15
+  int64_t atan = (int64_t)450 * r + (((int64_t)r * (32768 - r)) >> 15) * (1402*32768 + 380*(int64_t)r) / (10*32768);
+  int32_t result = (atan + (1 << 14)) >> 15;              // tenths of degree
+  if (x > y)
+    result = 900 - result;
+  if (north < 0)
+    result = 1800 - result;
+  if (east < 0)
+    result = 3600 - result;
+  return ((result + 5) / 10) % 360;
 }
 #endif
 
@@ -65,6 +65,32 @@ int16_t ex_chans[NUM_CHNOUT] = {0}; // Outputs (before LIMITS) of the last perMa
   int16_t cyc_anas[3] = {0};
 #endif
 
+static inline void applyExpoWeight(int16_t *anas, ExpoData * ed, int v)
+{
+  uint8_t cur_chn = ed->chn;
+
+  //========== WEIGHT ===============
+  int16_t weight = GET_GVAR(ed->weight, MIN_EXPO_WEIGHT, 100, mixerCurrentFlightMode);
+  weight = calc100to256(weight);
+  v = ((int32_t)v * weight) >> 8;
+
+#if defined(VIRTUALINPUTS)
+  //========== OFFSET ===============
+  int16_t offset = GET_GVAR(ed->offset, -100, 100, mixerCurrentFlightMode);
+  if (offset) v += calc100toRESX(offset);
+
+  //========== TRIMS ================
+  if (ed->carryTrim < TRIM_ON)
+    virtualInputsTrims[cur_chn] = -ed->carryTrim - 1;
+  else if (ed->carryTrim == TRIM_ON && ed->srcRaw >= MIXSRC_Rud && ed->srcRaw <= MIXSRC_Ail)
+    virtualInputsTrims[cur_chn] = ed->srcRaw - MIXSRC_Rud;
+  else
+    virtualInputsTrims[cur_chn] = -1;
+#endif
+
+  anas[cur_chn] = v;
+}
+
 void applyExpos(int16_t *anas, uint8_t mode APPLY_EXPOS_EXTRA_PARAMS)
 {
 #if !defined(VIRTUALINPUTS)
@@ -72,6 +98,15 @@ void applyExpos(int16_t *anas, uint8_t mode APPLY_EXPOS_EXTRA_PARAMS)
   memcpy(anas2, anas, sizeof(anas2));
 #endif
 
+#if defined(CPUARM)
+  // the active lines (at most one per input) are collected first, then their expo
+  // curves are computed in batches of lines sharing the same expo value
+  uint8_t linesCount = 0;
+  uint8_t lines[NUM_INPUTS];
+  int values[NUM_INPUTS];
+  int8_t expos[NUM_INPUTS];
+#endif
+
   int8_t cur_chn = -1;
 
   for (uint8_t i=0; i<MAX_EXPOS; i++) {
@@ -107,9 +142,15 @@ void applyExpos(int16_t *anas, uint8_t mode APPLY_EXPOS_EXTRA_PARAMS)
         cur_chn = ed->chn;
 
         //========== CURVE=================
+#if defined(CPUARM)
+        int8_t expoValue = 0;
+#endif
 #if defined(XCURVES)
         if (ed->curve.value) {
-          v = applyCurve(v, ed->curve);
+          if (ed->curve.type == CURVE_REF_EXPO)
+            expoValue = GET_GVAR(ed->curve.value, -100, 100, mixerCurrentFlightMode);
+          else
+            v = applyCurve(v, ed->curve);
         }
 #else
         int8_t curveParam = ed->curveParam;
@@ -117,33 +158,49 @@ void applyExpos(int16_t *anas, uint8_t mode APPLY_EXPOS_EXTRA_PARAMS)
           if (ed->curveMode == MODE_CURVE)
             v = applyCurve(v, curveParam);
           else
+#if defined(CPUARM)
+            expoValue = GET_GVAR(curveParam, -100, 100, mixerCurrentFlightMode);
+#else
             v = expo(v, GET_GVAR(curveParam, -100, 100, mixerCurrentFlightMode));
+#endif
         }
 #endif
 
-        //========== WEIGHT ===============
-        int16_t weight = GET_GVAR(ed->weight, MIN_EXPO_WEIGHT, 100, mixerCurrentFlightMode);
-        weight = calc100to256(weight);
-        v = ((int32_t)v * weight) >> 8;
-
-#if defined(VIRTUALINPUTS)
-        //========== OFFSET ===============
-        int16_t offset = GET_GVAR(ed->offset, -100, 100, mixerCurrentFlightMode);
-        if (offset) v += calc100toRESX(offset);
-
-        //========== TRIMS ================
-        if (ed->carryTrim < TRIM_ON)
-          virtualInputsTrims[cur_chn] = -ed->carryTrim - 1;
-        else if (ed->carryTrim == TRIM_ON && ed->srcRaw >= MIXSRC_Rud && ed->srcRaw <= MIXSRC_Ail)
-          virtualInputsTrims[cur_chn] = ed->srcRaw - MIXSRC_Rud;
-        else
-          virtualInputsTrims[cur_chn] = -1;
+#if defined(CPUARM)
+        lines[linesCount] = i;
+        values[linesCount] = v;
+        expos[linesCount] = expoValue;
+        linesCount++;
+#else
+        applyExpoWeight(anas, ed, v);
 #endif
-
-        anas[cur_chn] = v;
       }
     }
   }
+
+#if defined(CPUARM)
+  // group the lines by expo value
+  for (uint8_t i=1; i<linesCount; i++) {
+    for (uint8_t j=i; j>0 && expos[j-1]>expos[j]; j--) {
+      SWAP(lines[j-1], lines[j]);
+      SWAP(values[j-1], values[j]);
+      SWAP(expos[j-1], expos[j]);
+    }
+  }
+
+  for (uint8_t first=0, last; first<linesCount; first=last) {
+    for (last=first+1; last<linesCount && expos[last]==expos[first]; last++);
+    expoBatch(&values[first], last-first, expos[first]);
+  }
+
+  for (uint8_t i=0; i<linesCount; i++) {
+#if defined(VIRTUALINPUTS)
+    applyExpoWeight(anas, expoAddress(lines[i]), values[i]);
+#else
+    applyExpoWeight(anas, expoAddress(lines[i]), (int16_t)values[i]);
+#endif
+  }
+#endif
 }
 
 // #define PREVENT_ARITHMETIC_OVERFLOW
@@ -240,33 +297,216 @@ int16_t applyLimits(uint8_t channel, int32_t value)
 
 // TODO same naming convention than the putsMixerSource
 
-getvalue_t getValue(mixsrc_t i)
+#if defined(CPUARM)
+/* Sources are split into contiguous ranges, each one read by its own function
+   with the index of the source inside the range. getValueTable gives the
+   range of each source, so that getValue() is 2 table lookups and a call
+   whatever the source */
+
+typedef getvalue_t (*GetValueFunction)(unsigned int index);
+
+struct GetValueRange {
+  mixsrc_t first;
+  GetValueFunction get;
+};
+
+static getvalue_t getValueZero(unsigned int index)
 {
-  if (i==MIXSRC_NONE) return 0;
+  return 0;
+}
 
 #if defined(VIRTUALINPUTS)
-  else if (i <= MIXSRC_LAST_INPUT) {
-    return anas[i-MIXSRC_FIRST_INPUT];
-  }
-#endif
+static getvalue_t getValueInput(unsigned int index)
+{
+  return anas[index];
+}
 
-#if defined(LUAINPUTS)
-  else if (i<MIXSRC_LAST_LUA) {
+static getvalue_t getValueLua(unsigned int index)
+{
 #if defined(LUA_MODEL_SCRIPTS)
-    div_t qr = div(i-MIXSRC_FIRST_LUA, MAX_SCRIPT_OUTPUTS);
-    return scriptInputsOutputs[qr.quot].outputs[qr.rem].value;
+  return scriptInputsOutputs[index / MAX_SCRIPT_OUTPUTS].outputs[index % MAX_SCRIPT_OUTPUTS].value;
+#else
+  return 0;
+#endif
+}
+#endif
+
+static getvalue_t getValueStick(unsigned int index)
+{
+  return calibratedStick[index];
+}
+
+#if defined(ROTARY_ENCODERS)
+static getvalue_t getValueRotaryEncoder(unsigned int index)
+{
+  return getRotaryEncoder(index);
+}
 #else
+  #define getValueRotaryEncoder getValueZero
+#endif
+
+static getvalue_t getValueMax(unsigned int index)
+{
+  return 1024;
+}
+
+#if defined(HELI)
+static getvalue_t getValueCyclic(unsigned int index)
+{
+  return cyc_anas[index];
+}
+#else
+  #define getValueCyclic getValueZero
+#endif
+
+static getvalue_t getValueTrim(unsigned int index)
+{
+  return calc1000toRESX((int16_t)8 * getTrimValue(mixerCurrentFlightMode, index));
+}
+
+#if defined(PCBTARANIS)
+static getvalue_t getValueSwitch(unsigned int index)
+{
+  if (SWITCH_EXISTS(index)) {
+    return (switchState((EnumKeys)(SW_BASE+(3*index))) ? -1024 : (switchState((EnumKeys)(SW_BASE+(3*index)+1)) ? 0 : 1024));
+  }
+  else {
     return 0;
+  }
+}
+#else
+static getvalue_t getValue3Pos(unsigned int index)
+{
+  return (getSwitch(SW_ID0-SW_BASE+1) ? -1024 : (getSwitch(SW_ID1-SW_BASE+1) ? 0 : 1024));
+}
+
+static getvalue_t getValueSwitch(unsigned int index)
+{
+  // don't use switchState directly to give getSwitch possibility to hack values if needed for switch warning
+  return getSwitch(SWSRC_THR+index) ? 1024 : -1024;
+}
 #endif
+
+static getvalue_t getValueLogicalSwitch(unsigned int index)
+{
+  return getSwitch(SWSRC_FIRST_LOGICAL_SWITCH+index) ? 1024 : -1024;
+}
+
+static getvalue_t getValueTrainer(unsigned int index)
+{
+  int16_t x = ppmInput[index];
+  if (index < NUM_CAL_PPM) {
+    x -= g_eeGeneral.trainer.calib[index];
   }
+  return x*2;
+}
+
+static getvalue_t getValueChannel(unsigned int index)
+{
+  return ex_chans[index];
+}
+
+#if defined(GVARS)
+static getvalue_t getValueGVar(unsigned int index)
+{
+  return GVAR_VALUE(index, getGVarFlightPhase(mixerCurrentFlightMode, index));
+}
+#else
+  #define getValueGVar getValueZero
 #endif
 
-#if defined(LUAINPUTS)
-  else if (i<=MIXSRC_LAST_POT) return calibratedStick[i-MIXSRC_Rud];
+static getvalue_t getValueTxVoltage(unsigned int index)
+{
+  return g_vbat100mV;
+}
+
+#if defined(RTCLOCK)
+static getvalue_t getValueTxTime(unsigned int index)
+{
+  return (g_rtcTime % SECS_PER_DAY) / 60; // number of minutes from midnight
+}
 #else
-  else if (i>=MIXSRC_FIRST_STICK && i<=MIXSRC_LAST_POT) return calibratedStick[i-MIXSRC_Rud];
+  #define getValueTxTime getValueZero
 #endif
 
+static getvalue_t getValueTimer(unsigned int index)
+{
+  return timersStates[index].val;
+}
+
+static getvalue_t getValueTelemetry(unsigned int index)
+{
+  TelemetryItem & telemetryItem = telemetryItems[index / 3];
+  switch (index % 3) {
+    case 1:
+      return telemetryItem.valueMin;
+    case 2:
+      return telemetryItem.valueMax;
+    default:
+      return telemetryItem.value;
+  }
+}
+
+// must be sorted by first source
+static const GetValueRange getValueRanges[] = {
+  { MIXSRC_NONE, getValueZero },
+#if defined(VIRTUALINPUTS)
+  { MIXSRC_FIRST_INPUT, getValueInput },
+  { MIXSRC_FIRST_LUA, getValueLua },
+#endif
+  { MIXSRC_FIRST_STICK, getValueStick },
+#if defined(PCBSKY9X)
+  { MIXSRC_REa, getValueRotaryEncoder },
+#endif
+  { MIXSRC_MAX, getValueMax },
+  { MIXSRC_FIRST_HELI, getValueCyclic },
+  { MIXSRC_FIRST_TRIM, getValueTrim },
+#if defined(PCBTARANIS)
+  { MIXSRC_FIRST_SWITCH, getValueSwitch },
+#else
+  { MIXSRC_3POS, getValue3Pos },
+  { MIXSRC_THR, getValueSwitch },
+#endif
+  { MIXSRC_FIRST_LOGICAL_SWITCH, getValueLogicalSwitch },
+  { MIXSRC_FIRST_TRAINER, getValueTrainer },
+  { MIXSRC_FIRST_CH, getValueChannel },
+  { MIXSRC_FIRST_GVAR, getValueGVar },
+  { MIXSRC_TX_VOLTAGE, getValueTxVoltage },
+  { MIXSRC_TX_TIME, getValueTxTime },      // the reserved sources after it give the time as well
+  { MIXSRC_FIRST_TIMER, getValueTimer },
+  { MIXSRC_FIRST_TELEM, getValueTelemetry },
+};
+
+struct GetValueTable {
+  uint8_t range[MIXSRC_LAST_TELEM+1];
+  GetValueTable();
+};
+
+GetValueTable::GetValueTable()
+{
+  uint8_t r = 0;
+  for (unsigned int i=0; i<=MIXSRC_LAST_TELEM; i++) {
+    while (r<DIM(getValueRanges)-1 && i>=getValueRanges[r+1].first) {
+      r++;
+    }
+    range[i] = r;
+  }
+}
+
+GetValueTable getValueTable;
+
+getvalue_t getValue(mixsrc_t i)
+{
+  if (i > MIXSRC_LAST_TELEM) return 0;
+  const GetValueRange & range = getValueRanges[getValueTable.range[i]];
+  return range.get(i - range.first);
+}
+#else
+getvalue_t getValue(mixsrc_t i)
+{
+  if (i==MIXSRC_NONE) return 0;
+  else if (i>=MIXSRC_FIRST_STICK && i<=MIXSRC_LAST_POT) return calibratedStick[i-MIXSRC_Rud];
+
 #if defined(PCBGRUVIN9X) || defined(PCBMEGA2560) || defined(ROTARY_ENCODERS)
   else if (i<=MIXSRC_LAST_ROTARY_ENCODER) return getRotaryEncoder(i-MIXSRC_REa);
 #endif
@@ -281,22 +521,9 @@ getvalue_t getValue(mixsrc_t i)
 #endif
 
   else if (i<=MIXSRC_TrimAil) return calc1000toRESX((int16_t)8 * getTrimValue(mixerCurrentFlightMode, i-MIXSRC_TrimRud));
-
-#if defined(PCBTARANIS)
-  else if ((i >= MIXSRC_FIRST_SWITCH) && (i <= MIXSRC_LAST_SWITCH)) {
-    mixsrc_t sw = i-MIXSRC_FIRST_SWITCH;
-    if (SWITCH_EXISTS(sw)) {
-      return (switchState((EnumKeys)(SW_BASE+(3*sw))) ? -1024 : (switchState((EnumKeys)(SW_BASE+(3*sw)+1)) ? 0 : 1024));
-    }
-    else {
-      return 0;
-    }
-  }
-#else
   else if (i==MIXSRC_3POS) return (getSwitch(SW_ID0-SW_BASE+1) ? -1024 : (getSwitch(SW_ID1-SW_BASE+1) ? 0 : 1024));
   // don't use switchState directly to give getSwitch possibility to hack values if needed for switch warning
   else if (i<MIXSRC_SW1) return getSwitch(SWSRC_THR+i-MIXSRC_THR) ? 1024 : -1024;
-#endif
   else if (i<=MIXSRC_LAST_LOGICAL_SWITCH) return getSwitch(SWSRC_FIRST_LOGICAL_SWITCH+i-MIXSRC_FIRST_LOGICAL_SWITCH) ? 1024 : -1024;
   else if (i<=MIXSRC_LAST_TRAINER) { int16_t x = ppmInput[i-MIXSRC_FIRST_TRAINER]; if (i<MIXSRC_FIRST_TRAINER+NUM_CAL_PPM) { x-= g_eeGeneral.trainer.calib[i-MIXSRC_FIRST_TRAINER]; } return x*2; }
   else if (i<=MIXSRC_LAST_CH) return ex_chans[i-MIXSRC_CH1];
@@ -305,35 +532,10 @@ getvalue_t getValue(mixsrc_t i)
   else if (i<=MIXSRC_LAST_GVAR) return GVAR_VALUE(i-MIXSRC_GVAR1, getGVarFlightPhase(mixerCurrentFlightMode, i-MIXSRC_GVAR1));
 #endif
 
-#if defined(CPUARM)
-  else if (i==MIXSRC_TX_VOLTAGE) return g_vbat100mV;
-  else if (i<MIXSRC_FIRST_TIMER) // TX_TIME + SPARES
-  #if defined(RTCLOCK)
-     return (g_rtcTime % SECS_PER_DAY) / 60; // number of minutes from midnight
-  #else
-     return 0;
-  #endif
-  else if (i<=MIXSRC_LAST_TIMER) return timersStates[i-MIXSRC_FIRST_TIMER].val;
-#else
   else if (i==MIXSRC_FIRST_TELEM-1+TELEM_TX_VOLTAGE) return g_vbat100mV;
   else if (i<=MIXSRC_FIRST_TELEM-1+TELEM_TIMER2) return timersStates[i-MIXSRC_FIRST_TELEM+1-TELEM_TIMER1].val;
-#endif
 
-#if defined(CPUARM)
-  else if (i<=MIXSRC_LAST_TELEM) {
-    i -= MIXSRC_FIRST_TELEM;
-    div_t qr = div(i, 3);
-    TelemetryItem & telemetryItem = telemetryItems[qr.quot];
-    switch (qr.rem) {
-      case 1:
-        return telemetryItem.valueMin;
-      case 2:
-        return telemetryItem.valueMax;
-      default:
-        return telemetryItem.value;
-    }
-  }
-#elif defined(FRSKY)
+#if defined(FRSKY)
   else if (i==MIXSRC_FIRST_TELEM-1+TELEM_RSSI_TX) return frskyData.rssi[1].value;
   else if (i==MIXSRC_FIRST_TELEM-1+TELEM_RSSI_RX) return frskyData.rssi[0].value;
   else if (i==MIXSRC_FIRST_TELEM-1+TELEM_A1) return frskyData.analog[TELEM_ANA_A1].value;
@@ -372,6 +574,8 @@ getvalue_t getValue(mixsrc_t i)
   else return 0;
 }
 
+#endif
+
 void evalInputs(uint8_t mode)
 {
   BeepANACenter anaCenter = 0;
@@ -541,12 +745,255 @@ int getSourceTrimValue(int source, int stickValue=0)
 }
 #endif
 
+#if defined(CPUARM)
+// The mixer plan is the list of mix lines in execution order. Lines stay grouped by
+// destination channel, and a channel is always computed after the channels it uses
+// as sources, so that one single pass gives the final result.
+// It is compiled when the model is loaded or edited, not on each mixer cycle
+uint8_t mixerPlan[MAX_MIXERS];
+uint8_t mixerPlanCount = 0;
+uint8_t mixerPlanState = MIXER_PLAN_DIRTY;
+uint8_t mixerDynamicSources = 0;
+
+// Runtime mirror of the mix lines, in plan order. The fields needed by every line
+// are decoded once from the packed MixData when the plan is compiled
+enum MixerLineFlags {
+  MIXER_LINE_FIRST = 0x01,      // first line of its channel
+  MIXER_LINE_CONDITION = 0x02,  // flight modes or switch
+  MIXER_LINE_SLOW = 0x04,
+  MIXER_LINE_TRAINER = 0x08,
+  MIXER_LINE_LUA = 0x10
+};
+
+struct MixerLines {
+  uint8_t  destCh[MAX_MIXERS];
+  mixsrc_t srcRaw[MAX_MIXERS];
+  uint16_t flightModes[MAX_MIXERS];
+  swsrc_t  swtch[MAX_MIXERS];
+  uint8_t  flags[MAX_MIXERS];
+};
+
+MixerLines mixerLines;
+
+void compileMixerLine(uint8_t k, uint8_t i)
+{
+  MixData * md = mixAddress(i);
+  uint8_t flags = 0;
+  if (i == 0 || md->destCh != (md-1)->destCh)
+    flags |= MIXER_LINE_FIRST;
+  if (md->flightModes != 0 || md->swtch)
+    flags |= MIXER_LINE_CONDITION;
+  if (md->speedUp || md->speedDown)
+    flags |= MIXER_LINE_SLOW;
+  if (md->srcRaw >= MIXSRC_FIRST_TRAINER && md->srcRaw <= MIXSRC_LAST_TRAINER)
+    flags |= MIXER_LINE_TRAINER;
+#if defined(LUA_MODEL_SCRIPTS)
+  if (md->srcRaw >= MIXSRC_FIRST_LUA && md->srcRaw <= MIXSRC_LAST_LUA)
+    flags |= MIXER_LINE_LUA;
+#endif
+  mixerLines.destCh[k] = md->destCh;
+  mixerLines.srcRaw[k] = md->srcRaw;
+  mixerLines.flightModes[k] = md->flightModes;
+  mixerLines.swtch[k] = md->swtch;
+  mixerLines.flags[k] = flags;
+}
+
+void addMixerDynamicSource(mixsrc_t source)
+{
+#if defined(VIRTUALINPUTS)
+  if (source >= MIXSRC_FIRST_LUA && source <= MIXSRC_LAST_LUA)
+    mixerDynamicSources |= MIXER_DYNAMIC_LUA;
+#endif
+  if (source >= MIXSRC_FIRST_TELEM && source <= MIXSRC_LAST_TELEM)
+    mixerDynamicSources |= MIXER_DYNAMIC_TELEMETRY;
+  else if (source == MIXSRC_TX_VOLTAGE || source == MIXSRC_TX_TIME)
+    mixerDynamicSources |= MIXER_DYNAMIC_TX;
+}
+
+void compileMixerPlan()
+{
+  uint8_t first[NUM_CHNOUT];
+  bitfield_channels_t depends[NUM_CHNOUT];
+  bitfield_channels_t used = 0;
+  uint8_t count;
+
+  memclear(depends, sizeof(depends));
+  mixerPlanState = MIXER_PLAN_SORTED;
+  mixerDynamicSources = 0;
+
+#if defined(VIRTUALINPUTS)
+  for (uint8_t i=0; i<MAX_EXPOS; i++) {
+    ExpoData * ed = expoAddress(i);
+    if (!EXPO_VALID(ed)) break;
+    addMixerDynamicSource(ed->srcRaw);
+  }
+#endif
+
+#if defined(HELI)
+#if defined(VIRTUALINPUTS)
+  addMixerDynamicSource(g_model.swashR.elevatorSource);
+  addMixerDynamicSource(g_model.swashR.aileronSource);
+#endif
+  addMixerDynamicSource(g_model.swashR.collectiveSource);
+#endif
+
+  for (count=0; count<MAX_MIXERS; count++) {
+    MixData * md = mixAddress(count);
+    if (md->srcRaw == 0) break;
+    addMixerDynamicSource(md->srcRaw);
+    bitfield_channels_t mask = (bitfield_channels_t)1 << md->destCh;
+    if (count == 0 || md->destCh != (md-1)->destCh) {
+      if (used & mask) {
+        // lines of this channel are not contiguous
+        mixerPlanState = MIXER_PLAN_RECURSIVE;
+      }
+      used |= mask;
+      first[md->destCh] = count;
+    }
+    if (md->srcRaw >= MIXSRC_CH1 && md->srcRaw <= MIXSRC_LAST_CH && md->srcRaw-MIXSRC_CH1 != md->destCh) {
+      depends[md->destCh] |= (bitfield_channels_t)1 << (md->srcRaw-MIXSRC_CH1);
+    }
+  }
+
+  mixerPlanCount = count;
+
+  if (mixerPlanState == MIXER_PLAN_SORTED) {
+    bitfield_channels_t done = 0;
+    uint8_t k = 0;
+    while (done != used) {
+      uint8_t ch;
+      // always take the lowest ready channel, the plan keeps the mix lines order when there are no dependencies
+      for (ch=0; ch<NUM_CHNOUT; ch++) {
+        bitfield_channels_t mask = (bitfield_channels_t)1 << ch;
+        if ((used & mask) && !(done & mask) && !(depends[ch] & used & ~done)) {
+          for (uint8_t i=first[ch]; i<count && mixAddress(i)->destCh==ch; i++) {
+            mixerPlan[k++] = i;
+          }
+          done |= mask;
+          break;
+        }
+      }
+      if (ch == NUM_CHNOUT) {
+        // recursive channels, the mixer will need several passes
+        mixerPlanState = MIXER_PLAN_RECURSIVE;
+        break;
+      }
+    }
+  }
+
+  if (mixerPlanState != MIXER_PLAN_SORTED) {
+    for (uint8_t i=0; i<count; i++) {
+      mixerPlan[i] = i;
+    }
+  }
+
+  for (uint8_t k=0; k<count; k++) {
+    compileMixerLine(k, mixerPlan[k]);
+  }
+}
+
+inline bool isMixerPlanValid()
+{
+  // mix lines inserted / deleted without the model being marked dirty yet
+  if (mixerPlanCount < MAX_MIXERS && mixAddress(mixerPlanCount)->srcRaw != 0)
+    return false;
+  if (mixerPlanCount > 0 && mixAddress(mixerPlanCount-1)->srcRaw == 0)
+    return false;
+  return mixerPlanState != MIXER_PLAN_DIRTY;
+}
+
+// Quiescence detector: between two 10ms ticks the logical switches, functions, timers,
+// slow and delay states and flight mode fades don't evolve, the mixer outputs only
+// depend on the inputs hashed below. When they are unchanged since the last evaluation,
+// and this evaluation left the mixer in a stable state, the outputs are reused
+bool     mixerSettled = false;
+bool     mixerTransitionsActive = false;
+uint32_t mixerInputsHash = 0;
+uint32_t mixerCyclesCount = 0;
+uint32_t mixerFastPathCount = 0;
+
+#define MIXER_HASH(hash, value) hash = ((hash) ^ (uint32_t)(value)) * 16777619u
+
+uint32_t hashMixerSources(uint32_t hash, mixsrc_t first, mixsrc_t last)
+{
+  for (mixsrc_t source=first; source<=last; source++) {
+    MIXER_HASH(hash, getValue(source));
+  }
+  return hash;
+}
+
+uint32_t getMixerInputsHash()
+{
+  uint32_t hash = 2166136261u;
+
+  for (uint8_t i=0; i<NUM_STICKS+NUM_POTS; i++) {
+    MIXER_HASH(hash, anaIn(i));
+  }
+
+#if defined(PCBTARANIS)
+  MIXER_HASH(hash, switchesPos);
+  MIXER_HASH(hash, switchesPos >> 32);
+  for (uint8_t i=0; i<NUM_XPOTS; i++) {
+    MIXER_HASH(hash, potsPos[i]);
+  }
+#else
+  for (uint8_t i=0; i<=SWSRC_LAST_SWITCH-SWSRC_FIRST_SWITCH; i++) {
+    MIXER_HASH(hash, switchState((EnumKeys)(SW_BASE+i)));
+  }
+#endif
+
+  if (IS_TRAINER_INPUT_VALID()) {
+    for (uint8_t i=0; i<NUM_TRAINER; i++) {
+      MIXER_HASH(hash, ppmInput[i]);
+    }
+  }
+
+  // trims, GVARs and rotary encoders
+  const uint8_t * flightModes = (const uint8_t *)g_model.flightModeData;
+  for (unsigned int i=0; i<sizeof(g_model.flightModeData); i++) {
+    MIXER_HASH(hash, flightModes[i]);
+  }
+
+#if defined(VIRTUALINPUTS)
+  if (mixerDynamicSources & MIXER_DYNAMIC_LUA) {
+    hash = hashMixerSources(hash, MIXSRC_FIRST_LUA, MIXSRC_LAST_LUA);
+  }
+#endif
+  if (mixerDynamicSources & MIXER_DYNAMIC_TELEMETRY) {
+    hash = hashMixerSources(hash, MIXSRC_FIRST_TELEM, MIXSRC_LAST_TELEM);
+  }
+  if (mixerDynamicSources & MIXER_DYNAMIC_TX) {
+    hash = hashMixerSources(hash, MIXSRC_TX_VOLTAGE, MIXSRC_TX_TIME);
+  }
+
+  return hash;
+}
+
+bool isMixerQuiescent(uint8_t tick10ms)
+{
+  uint32_t hash = getMixerInputsHash();
+  bool result = (!tick10ms && mixerSettled && s_mixer_first_run_done && hash == mixerInputsHash && isMixerPlanValid());
+  mixerInputsHash = hash;
+  mixerCyclesCount++;
+  if (result) {
+    mixerFastPathCount++;
+  }
+  return result;
+}
+#endif
+
 uint8_t mixerCurrentFlightMode;
 void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
 {
+  PROFILER_START(inputsTime);
   evalInputs(mode);
+  PROFILER_STOP(PROFILER_STAGE_INPUTS, inputsTime);
 
-  if (tick10ms) evalLogicalSwitches(mode==e_perout_mode_normal);
+  if (tick10ms) {
+    PROFILER_START(logicalSwitchesTime);
+    evalLogicalSwitches(mode==e_perout_mode_normal);
+    PROFILER_STOP(PROFILER_STAGE_LOGICAL_SWITCHES, logicalSwitchesTime);
+  }
 
 #if defined(MODULE_ALWAYS_SEND_PULSES)
   checkStartupWarnings();
@@ -641,11 +1088,24 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
 
   bitfield_channels_t dirtyChannels = (bitfield_channels_t)-1; // all dirty when mixer starts
 
+#if defined(CPUARM)
+  if (!isMixerPlanValid()) {
+    compileMixerPlan();
+  }
+  bool sorted = (mixerPlanState == MIXER_PLAN_SORTED);
+#endif
+
   do {
 
+    PROFILER_START(passTime);
     bitfield_channels_t passDirtyChannels = 0;
 
+#if defined(CPUARM)
+    for (uint8_t k=0; k<mixerPlanCount; k++) {
+      uint8_t i = mixerPlan[k];
+#else
     for (uint8_t i=0; i<MAX_MIXERS; i++) {
+#endif
 
 #if defined(BOLD_FONT)
       if (mode==e_perout_mode_normal && pass==0) swOn[i].activeMix = 0;
@@ -653,31 +1113,52 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
 
       MixData *md = mixAddress(i);
 
+#if defined(CPUARM)
+      uint8_t destCh = mixerLines.destCh[k];
+      mixsrc_t mixSource = mixerLines.srcRaw[k];
+      uint8_t lineFlags = mixerLines.flags[k];
+#else
       if (md->srcRaw == 0) break;
+      uint8_t destCh = md->destCh;
+      mixsrc_t mixSource = md->srcRaw;
+#endif
 
-      mixsrc_t stickIndex = md->srcRaw - MIXSRC_Rud;
+      mixsrc_t stickIndex = mixSource - MIXSRC_Rud;
 
-      if (!(dirtyChannels & ((bitfield_channels_t)1 << md->destCh))) continue;
+      if (!(dirtyChannels & ((bitfield_channels_t)1 << destCh))) continue;
 
       // if this is the first calculation for the destination channel, initialize it with 0 (otherwise would be random)
-      if (i == 0 || md->destCh != (md-1)->destCh) {
-        chans[md->destCh] = 0;
+#if defined(CPUARM)
+      if (lineFlags & MIXER_LINE_FIRST) {
+#else
+      if (i == 0 || destCh != (md-1)->destCh) {
+#endif
+        chans[destCh] = 0;
       }
 
       //========== PHASE && SWITCH =====
+#if defined(CPUARM)
+      bool mixCondition = (lineFlags & MIXER_LINE_CONDITION);
+      delayval_t mixEnabled = (!(mixerLines.flightModes[k] & (1 << mixerCurrentFlightMode)) && getSwitch(mixerLines.swtch[k])) ? DELAY_POS_MARGIN+1 : 0;
+#else
       bool mixCondition = (md->flightModes != 0 || md->swtch);
       delayval_t mixEnabled = (!(md->flightModes & (1 << mixerCurrentFlightMode)) && getSwitch(md->swtch)) ? DELAY_POS_MARGIN+1 : 0;
+#endif
 
 #define MIXER_LINE_DISABLE()   (mixCondition = true, mixEnabled = 0)
 
-      if (mixEnabled && md->srcRaw >= MIXSRC_FIRST_TRAINER && md->srcRaw <= MIXSRC_LAST_TRAINER && !IS_TRAINER_INPUT_VALID()) {
+#if defined(CPUARM)
+      if (mixEnabled && (lineFlags & MIXER_LINE_TRAINER) && !IS_TRAINER_INPUT_VALID()) {
+#else
+      if (mixEnabled && mixSource >= MIXSRC_FIRST_TRAINER && mixSource <= MIXSRC_LAST_TRAINER && !IS_TRAINER_INPUT_VALID()) {
+#endif
         MIXER_LINE_DISABLE();
       }
 
 #if defined(LUA_MODEL_SCRIPTS)
       // disable mixer if Lua script is used as source and script was killed
-      if (mixEnabled && md->srcRaw >= MIXSRC_FIRST_LUA && md->srcRaw <= MIXSRC_LAST_LUA) {
-        div_t qr = div(md->srcRaw-MIXSRC_FIRST_LUA, MAX_SCRIPT_OUTPUTS);
+      if (mixEnabled && (lineFlags & MIXER_LINE_LUA)) {
+        div_t qr = div(mixSource-MIXSRC_FIRST_LUA, MAX_SCRIPT_OUTPUTS);
         if (scriptInternalData[qr.quot].state != SCRIPT_OK) {
           MIXER_LINE_DISABLE();
         }
@@ -692,7 +1173,7 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
           continue;
         }
         else {
-          v = getValue(md->srcRaw);
+          v = getValue(mixSource);
         }
 #else
         if (!mixEnabled || stickIndex >= NUM_STICKS || (stickIndex == THR_STICK && g_model.thrTrim)) {
@@ -714,11 +1195,20 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
           mixsrc_t srcRaw = MIXSRC_Rud + stickIndex;
           v = getValue(srcRaw);
           srcRaw -= MIXSRC_CH1;
-          if (srcRaw<=MIXSRC_LAST_CH-MIXSRC_CH1 && md->destCh != srcRaw) {
-            if (dirtyChannels & ((bitfield_channels_t)1 << srcRaw) & (passDirtyChannels|~(((bitfield_channels_t) 1 << md->destCh)-1)))
-              passDirtyChannels |= (bitfield_channels_t) 1 << md->destCh;
-            if (srcRaw < md->destCh || pass > 0)
+          if (srcRaw<=MIXSRC_LAST_CH-MIXSRC_CH1 && destCh != srcRaw) {
+#if defined(CPUARM)
+            if (sorted) {
+              // the source channel has already been computed in this pass
               v = chans[srcRaw] >> 8;
+            }
+            else
+#endif
+            {
+              if (dirtyChannels & ((bitfield_channels_t)1 << srcRaw) & (passDirtyChannels|~(((bitfield_channels_t) 1 << destCh)-1)))
+                passDirtyChannels |= (bitfield_channels_t) 1 << destCh;
+              if (srcRaw < destCh || pass > 0)
+                v = chans[srcRaw] >> 8;
+            }
           }
         }
         if (!mixCondition) {
@@ -733,12 +1223,14 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
       delayval_t _swPrev = swOn[i].prev;
       bool swTog = (mixEnabled > _swOn+DELAY_POS_MARGIN || mixEnabled < _swOn-DELAY_POS_MARGIN);
       if (mode==e_perout_mode_normal && swTog) {
+        MIXER_TRANSITION();
         if (!swOn[i].delay) _swPrev = _swOn;
         swOn[i].delay = (mixEnabled > _swOn ? md->delayUp : md->delayDown) * (100/DELAY_STEP);
         swOn[i].now = mixEnabled;
         swOn[i].prev = _swPrev;
       }
       if (mode==e_perout_mode_normal && swOn[i].delay > 0) {
+        MIXER_TRANSITION();
         swOn[i].delay = max<int16_t>(0, (int16_t)swOn[i].delay - tick10ms);
         if (!mixCondition)
           v = _swPrev << DELAY_POS_SHIFT;
@@ -750,7 +1242,11 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
           swOn[i].now = swOn[i].prev = mixEnabled;
         }
         if (!mixEnabled) {
+#if defined(CPUARM)
+          if ((lineFlags & MIXER_LINE_SLOW) && md->mltpx!=MLTPX_REP) {
+#else
           if ((md->speedDown || md->speedUp) && md->mltpx!=MLTPX_REP) {
+#endif
             if (mixCondition) {
               v = (md->mltpx == MLTPX_ADD ? 0 : RESX);
               apply_offset_and_curve = false;
@@ -775,7 +1271,7 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
         if (!(mode & e_perout_mode_notrims)) {
 #if defined(VIRTUALINPUTS)
           if (md->carryTrim == 0) {
-            v += getSourceTrimValue(md->srcRaw, v);
+            v += getSourceTrimValue(mixSource, v);
           }
 #else
           int8_t mix_trim = md->carryTrim;
@@ -804,12 +1300,17 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
       // now its on input side, but without weight compensation. More like other remote controls
       // lower weight causes slower movement
 
+#if defined(CPUARM)
+      if (mode <= e_perout_mode_inactive_flight_mode && (lineFlags & MIXER_LINE_SLOW)) { // there are delay values
+#else
       if (mode <= e_perout_mode_inactive_flight_mode && (md->speedUp || md->speedDown)) { // there are delay values
+#endif
 #define DEL_MULT_SHIFT 8
         // we recale to a mult 256 higher value for calculation
         int32_t tact = act[i];
         int16_t diff = v - (tact>>DEL_MULT_SHIFT);
         if (diff) {
+          MIXER_TRANSITION();
           // open.20.fsguruh: speed is defined in % movement per second; In menu we specify the full movement (-100% to 100%) = 200% in total
           // the unit of the stored value is the value from md->speedUp or md->speedDown divide SLOW_STEP seconds; e.g. value 4 means 4/SLOW_STEP = 2 seconds for CPU64
           // because we get a tick each 10msec, we need 100 ticks for one second
@@ -877,14 +1378,14 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
       }
 #endif
 
-      int32_t *ptr = &chans[md->destCh]; // Save calculating address several times
+      int32_t *ptr = &chans[destCh]; // Save calculating address several times
 
       switch (md->mltpx) {
         case MLTPX_REP:
           *ptr = dv;
 #if defined(BOLD_FONT)
           if (mode==e_perout_mode_normal) {
-            for (uint8_t m=i-1; m<MAX_MIXERS && mixAddress(m)->destCh==md->destCh; m--)
+            for (uint8_t m=i-1; m<MAX_MIXERS && mixAddress(m)->destCh==destCh; m--)
               swOn[m].activeMix = false;
           }
 #endif
@@ -943,9 +1444,18 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
 
     } //endfor mixers
 
+    PROFILER_STOP(PROFILER_STAGE_MIXES_PASS1 + pass, passTime);
+
     tick10ms = 0;
     dirtyChannels &= passDirtyChannels;
 
+#if defined(CPUARM)
+    if (sorted) {
+      // one single pass in dependency order, no need to iterate
+      break;
+    }
+#endif
+
   } while (++pass < 5 && dirtyChannels);
 
   mixWarning = lv_mixWarning;
@@ -973,7 +1483,23 @@ void evalMixes(uint8_t tick10ms)
   static ACTIVE_PHASES_TYPE flightModesFade = 0;
 
   LS_RECURSIVE_EVALUATION_RESET();
-  
+
+#if defined(CPUARM)
+  int16_t previousChans[NUM_CHNOUT];
+  memcpy(previousChans, ex_chans, sizeof(previousChans));
+  uint8_t previousFlightMode = lastFlightMode;
+  mixerTransitionsActive = false;
+  if (tick10ms) {
+    // the logical switches are only evaluated on the 10ms ticks, the count is kept until the next one
+    logicalSwitchesEvaluated = 0;
+  }
+#if defined(GVARS)
+  if (!gvarsCacheValid) {
+    updateGVarsCache();
+  }
+#endif
+#endif
+
   uint8_t fm = getFlightMode();
 
   if (lastFlightMode != fm) {
@@ -1016,19 +1542,42 @@ void evalMixes(uint8_t tick10ms)
 
   int32_t weight = 0;
   if (flightModesFade) {
+#if defined(CPUARM)
+    // the fading modes weights are normalized once (their sum is at most 1<<16),
+    // instead of dividing each channel by the total weight in the limits loop
+    uint32_t fadeWeight[MAX_FLIGHT_MODES];
+    for (uint8_t p=0; p<MAX_FLIGHT_MODES; p++) {
+      if (flightModesFade & ((ACTIVE_PHASES_TYPE)1 << p)) {
+        weight += fp_act[p];
+      }
+    }
+    assert(weight);
+    for (uint8_t p=0; p<MAX_FLIGHT_MODES; p++) {
+      if (flightModesFade & ((ACTIVE_PHASES_TYPE)1 << p)) {
+        fadeWeight[p] = ((uint32_t)fp_act[p] << 16) / weight;
+      }
+    }
+#endif
     memclear(sum_chans512, sizeof(sum_chans512));
     for (uint8_t p=0; p<MAX_FLIGHT_MODES; p++) {
       LS_RECURSIVE_EVALUATION_RESET();
       if (flightModesFade & ((ACTIVE_PHASES_TYPE)1 << p)) {
         mixerCurrentFlightMode = p;
         evalFlightModeMixes(p==fm ? e_perout_mode_normal : e_perout_mode_inactive_flight_mode, p==fm ? tick10ms : 0);
+#if defined(CPUARM)
+        for (uint8_t i=0; i<NUM_CHNOUT; i++)
+          sum_chans512[i] += (chans[i] >> 4) * (int32_t)fadeWeight[p];
+#else
         for (uint8_t i=0; i<NUM_CHNOUT; i++)
           sum_chans512[i] += (chans[i] >> 4) * fp_act[p];
         weight += fp_act[p];
+#endif
       }
       LS_RECURSIVE_EVALUATION_RESET();
     }
+#if !defined(CPUARM)
     assert(weight);
+#endif
     mixerCurrentFlightMode = fm;
   }
   else {
@@ -1045,23 +1594,32 @@ void evalMixes(uint8_t tick10ms)
 #endif
 
 #if defined(CPUARM)
+    PROFILER_START(functionsTime);
     if (!g_model.noGlobalFunctions) {
       evalFunctions(g_eeGeneral.customFn, globalFunctionsContext);
     }
     evalFunctions(g_model.customFn, modelFunctionsContext);
+    PROFILER_STOP(PROFILER_STAGE_FUNCTIONS, functionsTime);
 #else
     evalFunctions();
 #endif
   }
 
   //========== LIMITS ===============
+#if defined(CPUARM)
+  PROFILER_START(limitsTime);
+#endif
   for (uint8_t i=0; i<NUM_CHNOUT; i++) {
     // chans[i] holds data from mixer.   chans[i] = v*weight => 1024*256
     // later we multiply by the limit (up to 100) and then we need to normalize
     // at the end chans[i] = chans[i]/256 =>  -1024..1024
     // interpolate value with min/max so we get smooth motion from center to stop
     // this limits based on v original values and min=-1024, max=1024  RESX=1024
+#if defined(CPUARM)
+    int32_t q = (flightModesFade ? sum_chans512[i] >> 12 : chans[i]);
+#else
     int32_t q = (flightModesFade ? (sum_chans512[i] / weight) << 4 : chans[i]);
+#endif
 
 #if defined(PCBSTD)
     ex_chans[i] = q >> 8;
@@ -1075,6 +1633,7 @@ void evalMixes(uint8_t tick10ms)
     channelOutputs[i] = value;  // copy consistent word to int-level
     sei();
   }
+  PROFILER_STOP(PROFILER_STAGE_LIMITS, limitsTime);
 
   if (tick10ms && flightModesFade) {
     uint16_t tick_delta = delta * tick10ms;
@@ -1101,6 +1660,11 @@ void evalMixes(uint8_t tick10ms)
     }
   }
 
+#if defined(CPUARM)
+  // the next cycles will give the same outputs as long as the inputs don't change
+  mixerSettled = (!tick10ms && !flightModesFade && !mixerTransitionsActive && lastFlightMode == previousFlightMode && !memcmp(previousChans, ex_chans, sizeof(previousChans)));
+#endif
+
 #if defined(CPU2560) && defined(DEBUG) && !defined(VOICE)
   PORTH &= ~0x40; // PORTH:6 HIGH->LOW signals end of mixer interrupt
 #endif
@@ -660,6 +660,7 @@ PACK(typedef struct {
 #define CFN_PLAY_REPEAT_MUL     1
 #define CFN_PLAY_REPEAT_NOSTART 0xFF
 #define CFN_GVAR_MODE(p)        ((p)->all.mode)
+#define CFN_LOGS_FORMAT(p)      ((p)->all.mode)
 #define CFN_PARAM(p)            ((p)->all.val)
 #define CFN_RESET(p)            ((p)->active=0, (p)->clear.val1=0, (p)->clear.val2=0)
 #define CFN_GVAR_CST_MAX        GVAR_LIMIT
@@ -1265,7 +1266,8 @@ enum TelemetrySensorFormula
   TELEM_FORMULA_CELL,
   TELEM_FORMULA_CONSUMPTION,
   TELEM_FORMULA_DIST,
-  TELEM_FORMULA_LAST = TELEM_FORMULA_DIST
+  TELEM_FORMULA_BEARING,
+  TELEM_FORMULA_LAST = TELEM_FORMULA_BEARING
 };
 
 PACK(typedef struct {
@@ -1286,7 +1288,8 @@ PACK(typedef struct {
   uint8_t  logs:1;
   uint8_t  persistent:1;
   uint8_t  onlyPositive:1;
-  uint8_t  spare:3;
+  uint8_t  history:1;
+  uint8_t  spare:2;
   union {
     PACK(struct {
       uint16_t ratio;
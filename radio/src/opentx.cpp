@@ -696,7 +696,11 @@ void setGVarValue(uint8_t idx, int8_t value)
 uint8_t s_gvar_timer = 0;
 uint8_t s_gvar_last = 0;
 
+#if defined(CPUARM)
+uint8_t resolveGVarFlightPhase(uint8_t phase, uint8_t idx)
+#else
 uint8_t getGVarFlightPhase(uint8_t phase, uint8_t idx)
+#endif
 {
   for (uint8_t i=0; i<MAX_FLIGHT_MODES; i++) {
     if (phase == 0) return 0;
@@ -709,6 +713,33 @@ uint8_t getGVarFlightPhase(uint8_t phase, uint8_t idx)
   return 0;
 }
 
+#if defined(CPUARM)
+/* The flight mode each GVAR value comes from, resolved for all flight modes.
+   It is rebuilt by the mixer after the model has been modified, until then
+   the inheritance chain is walked as before
+*/
+uint8_t gvarsFlightModes[MAX_FLIGHT_MODES][MAX_GVARS];
+bool gvarsCacheValid = false;
+
+void updateGVarsCache()
+{
+  for (uint8_t phase=0; phase<MAX_FLIGHT_MODES; phase++) {
+    for (uint8_t idx=0; idx<MAX_GVARS; idx++) {
+      gvarsFlightModes[phase][idx] = resolveGVarFlightPhase(phase, idx);
+    }
+  }
+  gvarsCacheValid = true;
+}
+
+uint8_t getGVarFlightPhase(uint8_t phase, uint8_t idx)
+{
+  if (gvarsCacheValid)
+    return gvarsFlightModes[phase][idx];
+  else
+    return resolveGVarFlightPhase(phase, idx);
+}
+#endif
+
 int16_t getGVarValue(int16_t x, int16_t min, int16_t max, int8_t phase)
 {
   if (GV_IS_GV_VALUE(x, min, max)) {
@@ -1623,6 +1654,9 @@ void doMixerCalculations()
   adcPrepareBandgap();
 #endif
 
+#if defined(CPUARM)
+  if (!isMixerQuiescent(tick10ms))
+#endif
   evalMixes(tick10ms);
 
 #if !defined(CPUARM)
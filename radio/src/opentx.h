@@ -42,6 +42,11 @@
 #include <stddef.h>
 #include <stdlib.h>
 
+#if defined(SIMU) && defined(__SSE2__)
+  // must be included before the CMSIS headers, their __I define breaks it
+  #include <emmintrin.h>
+#endif
+
 #if defined(SIMU)
   #define SWITCH_SIMU(a, b)  (a)
 #else
@@ -474,9 +479,12 @@
 
 #if defined(XCURVES)
   void loadCurves();
+  void invalidateCurvesCache();
   #define LOAD_MODEL_CURVES() loadCurves()
+  #define INVALIDATE_CURVES_CACHE() invalidateCurvesCache()
 #else
   #define LOAD_MODEL_CURVES()
+  #define INVALIDATE_CURVES_CACHE()
 #endif
 
 #if defined(CPUARM)
@@ -734,6 +742,36 @@ extern uint8_t flightModeTransitionLast;
   #define availableMemory() ((unsigned int)((unsigned char *)&_heap_end - heap))
 #endif
 
+#if defined(CPUARM)
+  enum MixerPlanStates {
+    MIXER_PLAN_DIRTY,
+    MIXER_PLAN_SORTED,
+    MIXER_PLAN_RECURSIVE
+  };
+  extern uint8_t mixerPlanState;
+  void compileMixerPlan();
+  #define INVALIDATE_MIXER_PLAN() mixerPlanState = MIXER_PLAN_DIRTY
+  enum MixerDynamicSources {
+    MIXER_DYNAMIC_LUA = 0x01,
+    MIXER_DYNAMIC_TELEMETRY = 0x02,
+    MIXER_DYNAMIC_TX = 0x04
+  };
+  extern uint8_t mixerDynamicSources;
+  extern bool mixerSettled;
+  extern bool mixerTransitionsActive;
+  extern uint32_t mixerCyclesCount;
+  extern uint32_t mixerFastPathCount;
+  bool isMixerQuiescent(uint8_t tick10ms);
+  #define MIXER_TRANSITION() mixerTransitionsActive = true
+  #define INVALIDATE_MIXER_FAST_PATH() mixerSettled = false
+  #define RESET_MIXER_FAST_PATH_STATS() mixerCyclesCount = mixerFastPathCount = 0
+#else
+  #define INVALIDATE_MIXER_PLAN()
+  #define MIXER_TRANSITION()
+  #define INVALIDATE_MIXER_FAST_PATH()
+  #define RESET_MIXER_FAST_PATH_STATS()
+#endif
+
 void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms);
 void evalMixes(uint8_t tick10ms);
 void doMixerCalculations();
@@ -759,13 +797,17 @@ void logicalSwitchesReset();
 #if defined(CPUARM)
   void evalLogicalSwitches(bool isCurrentPhase=true);
   void logicalSwitchesCopyState(uint8_t src, uint8_t dst);
+  extern bool logicalSwitchesGraphValid;
+  extern uint16_t logicalSwitchesEvaluated;
   #define LS_RECURSIVE_EVALUATION_RESET()
+  #define INVALIDATE_LOGICAL_SWITCHES_GRAPH() logicalSwitchesGraphValid = false
 #else
   #define evalLogicalSwitches(xxx)
   #define GETSWITCH_RECURSIVE_TYPE uint16_t
   extern volatile GETSWITCH_RECURSIVE_TYPE s_last_switch_used;
   extern volatile GETSWITCH_RECURSIVE_TYPE s_last_switch_value;
   #define LS_RECURSIVE_EVALUATION_RESET() s_last_switch_used = 0
+  #define INVALIDATE_LOGICAL_SWITCHES_GRAPH()
 #endif
 
 #if defined(PCBTARANIS)
@@ -836,6 +878,11 @@ int getTrimValue(uint8_t phase, uint8_t idx);
     #define SET_GVAR(idx, val, p) setGVarValue(idx, val)  
   #else
     uint8_t getGVarFlightPhase(uint8_t phase, uint8_t idx);
+    #if defined(CPUARM)
+      extern bool gvarsCacheValid;
+      void updateGVarsCache();
+      #define INVALIDATE_GVARS_CACHE() gvarsCacheValid = false
+    #endif
     int16_t getGVarValue(int16_t x, int16_t min, int16_t max, int8_t phase);
     void setGVarValue(uint8_t x, int16_t value, int8_t phase);  
     #define GET_GVAR(x, min, max, p) getGVarValue(x, min, max, p)
@@ -848,6 +895,10 @@ int getTrimValue(uint8_t phase, uint8_t idx);
   #define GET_GVAR(x, ...) (x)
 #endif
 
+#if !defined(INVALIDATE_GVARS_CACHE)
+  #define INVALIDATE_GVARS_CACHE()
+#endif
+
 #if defined(CPUARM)
   #define GV_GET_GV1_VALUE(max)        ( (max<=GV_RANGESMALL && min>=GV_RANGESMALL_NEG) ? GV1_SMALL : GV1_LARGE )
   #define GV_INDEX_CALCULATION(x,max)  ( (max<=GV_RANGESMALL && min>=GV_RANGESMALL_NEG) ? (uint8_t) x-GV1_SMALL : ((x&(GV1_LARGE*2-1))-GV1_LARGE) )
@@ -949,6 +1000,13 @@ extern uint16_t lastMixerDuration;
   uint16_t getTmr16KHz();
 #endif
 
+#if defined(CPUARM)
+  #include "profiler.h"
+#else
+  #define PROFILER_START(timer)
+  #define PROFILER_STOP(stage, timer)
+#endif
+
 #if !defined(CPUARM)
   uint16_t stackAvailable();
 #endif
@@ -1160,6 +1218,9 @@ extern uint16_t           BandGap;
 
 int intpol(int x, uint8_t idx);
 int expo(int x, int k);
+#if defined(CPUARM)
+void expoBatch(int * values, uint8_t count, int k);
+#endif
 
 #if defined(CURVES) && defined(XCURVES)
   int applyCurve(int x, CurveRef & curve);
@@ -1356,6 +1417,8 @@ void evalFunctions();
 
 #if defined(CPUARM)
   #include "telemetry/telemetry.h"
+#else
+  #define INVALIDATE_TELEMETRY_INDEX()
 #endif
 
 #if defined (FRSKY)
@@ -1698,8 +1761,16 @@ extern uint8_t s_frsky_view;
 #define EARTH_RADIUSKM ((uint32_t)6371)
 #define EARTH_RADIUS ((uint32_t)111194)
 
-#if defined(PCBTARANIS)
-double gpsToDouble(bool neg, int16_t bp, int16_t ap);
+#if defined(CPUARM)
+// Flat earth approximation around the pilot position, the positions are in millionths
+// of degree, the offsets in decimeters. The longitude scale (cosine of the pilot latitude,
+// Q16) is computed once when the pilot position is locked. Up to 20km from the pilot the
+// distance error is below 0.5%, away from the poles
+uint32_t isqrt64(uint64_t n);
+uint32_t gpsLongitudeScale(int32_t latitude);
+void gpsGetOffset(int32_t pilotLatitude, int32_t pilotLongitude, uint32_t scale, int32_t latitude, int32_t longitude, int32_t * east, int32_t * north);
+uint32_t gpsGetDistance(int32_t east, int32_t north, int32_t height=0);
+uint16_t gpsGetBearing(int32_t east, int32_t north);
 #endif
 void getGpsPilotPosition();
 void getGpsDistance();
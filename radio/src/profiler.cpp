@@ -0,0 +1,93 @@
+/*
+ * Authors (alphabetical order)
+ * - Andre Bernet <bernet.andre@gmail.com>
+ * - Andreas Weitl
+ * - Bertrand Songis <bsongis@gmail.com>
+ * - Bryan J. Rentoul (Gruvin) <gruvin@gmail.com>
+ * - Cameron Weeks <th9xer@gmail.com>
+ * - Erez Raviv
+ * - Gabriel Birkus
+ * - Jean-Pierre Parisy
+ * - Karl Szmutny
+ * - Michael Blandford
+ * - Michal Hlavinka
+ * - Pat Mackenzie
+ * - Philip Moss
+ * - Rob Thomson
+ * - Romolo Manfredini <romolo.manfredini@gmail.com>
+ * - Thomas Husterer
+ *
+ * opentx is based on code named
+ * gruvin9x by Bryan J. Rentoul: http://code.google.com/p/gruvin9x/,
+ * er9x by Erez Raviv: http://code.google.com/p/er9x/,
+ * and the original (and ongoing) project by
+ * Thomas Husterer, th9x: http://code.google.com/p/th9x/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include "opentx.h"
+#include <stdio.h>
+
+MixerProfilerStage mixerProfilerStages[PROFILER_STAGES_COUNT];
+
+const char * const mixerProfilerStageNames[PROFILER_STAGES_COUNT] = {
+  "Inputs",
+  "LS",
+  "Mixes1", "Mixes2", "Mixes3", "Mixes4", "Mixes5",
+  "Funcs",
+  "Limits",
+  "Telem",
+};
+
+void mixerProfilerReset()
+{
+  memclear(mixerProfilerStages, sizeof(mixerProfilerStages));
+}
+
+uint8_t mixerProfilerBucket(profiler_time_t duration)
+{
+  uint8_t bucket = 0;
+  duration >>= PROFILER_HISTOGRAM_FIRST_SHIFT;
+  while (duration && bucket < PROFILER_HISTOGRAM_BUCKETS-1) {
+    duration >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+void mixerProfilerRecord(uint8_t stage, profiler_time_t duration)
+{
+  MixerProfilerStage & s = mixerProfilerStages[stage];
+  if (s.count == 0 || duration < s.min) s.min = duration;
+  if (duration > s.max) s.max = duration;
+  s.count++;
+  s.total += duration;
+  s.histogram[mixerProfilerBucket(duration)]++;
+}
+
+void mixerProfilerDump(void (*output)(const char *))
+{
+  char line[128];
+
+  output("Stage      Count    Min    Avg    Max [us] | <16 <32 <64 <128 <256 <512 <1k >1k");
+
+  for (uint8_t i=0; i<PROFILER_STAGES_COUNT; i++) {
+    const MixerProfilerStage & s = mixerProfilerStages[i];
+    if (s.count == 0) continue;
+    int len = snprintf(line, sizeof(line), "%-8s %7u %6u %6u %6u      |", mixerProfilerStageNames[i], (unsigned)s.count,
+                       (unsigned)PROFILER_DURATION_US(s.min), (unsigned)PROFILER_DURATION_US(s.total / s.count), (unsigned)PROFILER_DURATION_US(s.max));
+    for (uint8_t j=0; j<PROFILER_HISTOGRAM_BUCKETS && len>0 && len<(int)sizeof(line); j++) {
+      len += snprintf(line+len, sizeof(line)-len, " %u", (unsigned)s.histogram[j]);
+    }
+    output(line);
+  }
+}
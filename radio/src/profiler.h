@@ -0,0 +1,94 @@
+/*
+ * Authors (alphabetical order)
+ * - Andre Bernet <bernet.andre@gmail.com>
+ * - Andreas Weitl
+ * - Bertrand Songis <bsongis@gmail.com>
+ * - Bryan J. Rentoul (Gruvin) <gruvin@gmail.com>
+ * - Cameron Weeks <th9xer@gmail.com>
+ * - Erez Raviv
+ * - Gabriel Birkus
+ * - Jean-Pierre Parisy
+ * - Karl Szmutny
+ * - Michael Blandford
+ * - Michal Hlavinka
+ * - Pat Mackenzie
+ * - Philip Moss
+ * - Rob Thomson
+ * - Romolo Manfredini <romolo.manfredini@gmail.com>
+ * - Thomas Husterer
+ *
+ * opentx is based on code named
+ * gruvin9x by Bryan J. Rentoul: http://code.google.com/p/gruvin9x/,
+ * er9x by Erez Raviv: http://code.google.com/p/er9x/,
+ * and the original (and ongoing) project by
+ * Thomas Husterer, th9x: http://code.google.com/p/th9x/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef profiler_h
+#define profiler_h
+
+// Mixer execution profiler: each stage of the mixer task is timed with the
+// 2MHz timer (a high resolution clock in the simulator), so that the stage
+// which blows the 2ms budget of a given model can be identified.
+
+enum MixerProfilerStages {
+  PROFILER_STAGE_INPUTS,
+  PROFILER_STAGE_LOGICAL_SWITCHES,
+  PROFILER_STAGE_MIXES_PASS1,
+  PROFILER_STAGE_MIXES_PASS_LAST = PROFILER_STAGE_MIXES_PASS1 + 4,
+  PROFILER_STAGE_FUNCTIONS,
+  PROFILER_STAGE_LIMITS,
+  PROFILER_STAGE_TELEMETRY,
+  PROFILER_STAGES_COUNT
+};
+
+// Histogram bucket n counts the durations in [2^(n+4), 2^(n+5)[ ticks of 0.5us,
+// the first bucket holds everything below 16us and the last one everything above 1ms
+#define PROFILER_HISTOGRAM_BUCKETS     8
+#define PROFILER_HISTOGRAM_FIRST_SHIFT 5
+
+#if defined(SIMU)
+  typedef uint32_t profiler_time_t;
+  profiler_time_t getProfilerTime();
+#else
+  typedef uint16_t profiler_time_t;
+  #define getProfilerTime() getTmr2MHz()
+#endif
+
+struct MixerProfilerStage {
+  uint32_t count;
+  uint64_t total;
+  profiler_time_t min;
+  profiler_time_t max;
+  uint32_t histogram[PROFILER_HISTOGRAM_BUCKETS];
+};
+
+extern MixerProfilerStage mixerProfilerStages[PROFILER_STAGES_COUNT];
+extern const char * const mixerProfilerStageNames[PROFILER_STAGES_COUNT];
+
+void mixerProfilerReset();
+void mixerProfilerRecord(uint8_t stage, profiler_time_t duration);
+uint8_t mixerProfilerBucket(profiler_time_t duration);
+void mixerProfilerDump(void (*output)(const char *));
+
+#define PROFILER_DURATION_US(ticks)    ((ticks) / 2)
+
+#if defined(MIXER_PROFILER)
+  #define PROFILER_START(timer)        profiler_time_t timer = getProfilerTime()
+  #define PROFILER_STOP(stage, timer)  mixerProfilerRecord(stage, getProfilerTime() - timer)
+#else
+  #define PROFILER_START(timer)
+  #define PROFILER_STOP(stage, timer)
+#endif
+
+#endif // profiler_h
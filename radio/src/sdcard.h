@@ -59,6 +59,7 @@
 
 #define MODELS_EXT          ".bin"
 #define LOGS_EXT            ".csv"
+#define LOGS_BINARY_EXT     ".otl"
 #define SOUNDS_EXT          ".wav"
 #define BITMAPS_EXT         ".bmp"
 #define SCRIPTS_EXT         ".lua"
@@ -76,6 +77,87 @@ void writeHeader();
 void closeLogs();
 void writeLogs();
 
+#if defined(CPUARM)
+enum LogsFormat {
+  LOGS_FORMAT_CSV,
+  LOGS_FORMAT_BINARY
+};
+
+extern uint8_t logsFormat;
+
+// Binary logs: each session starts with a header and the description of its fields,
+// followed by fixed size records, either keyframes (int32 values) or deltas from the
+// previous record (int16 values). All values are little endian
+#define LOGS_BINARY_MAGIC            "OTXL"
+#define LOGS_BINARY_VERSION          1
+#define LOGS_BINARY_KEYFRAME         'K'
+#define LOGS_BINARY_DELTA            'D'
+#define LOGS_BINARY_KEYFRAME_PERIOD  50
+#define LOGS_BINARY_MAX_FIELDS       96
+
+enum LogsBinaryFieldKind {
+  LOGS_FIELD_TIME,       // 10ms ticks since the radio start
+  LOGS_FIELD_SENSOR,
+  LOGS_FIELD_LATITUDE,   // millionths of degree, positive North
+  LOGS_FIELD_LONGITUDE,  // millionths of degree, positive East
+  LOGS_FIELD_STICK,
+  LOGS_FIELD_SWITCH
+};
+
+PACK(struct LogsBinaryHeader {
+  char     magic[4];
+  uint8_t  version;
+  uint8_t  fieldsCount;
+  uint16_t period;       // 10ms ticks
+  uint32_t startTime;    // seconds since 1970, 0 without RTC
+});
+
+PACK(struct LogsBinaryField {
+  char     name[8];
+  char     unit[4];
+  uint8_t  prec;
+  uint8_t  kind;
+  uint8_t  spare[2];
+});
+
+void writeBinaryHeader();
+
+// The rows are formatted in a RAM buffer and written to the card by whole sectors,
+// f_sync is called every LOGS_SYNC_PERIOD seconds
+#define LOGS_SECTOR_SIZE          512
+#if defined(PCBTARANIS)
+  #define LOGS_BUFFER_SECTORS     8
+#else
+  #define LOGS_BUFFER_SECTORS     2
+#endif
+#define LOGS_BUFFER_SIZE          (LOGS_BUFFER_SECTORS*LOGS_SECTOR_SIZE)
+#define LOGS_PRINTF_BUFFER_SIZE   64
+#if !defined(LOGS_SYNC_PERIOD)
+  #define LOGS_SYNC_PERIOD        10
+#endif
+
+extern uint32_t logsDroppedRows;
+extern tmr10ms_t logsMaxFlushLatency;
+extern uint32_t logsQueueMaxDepth;
+
+enum LogsState {
+  LOGS_CLOSED,
+  LOGS_OPENING,
+  LOGS_OPENED,
+  LOGS_CLOSING
+};
+
+extern volatile uint8_t logsState;
+
+void logsBufferReset();
+void logsWrite(const void * data, uint32_t size);
+int logsPrintf(const char * format, ...);
+bool logsCommitRow();
+uint32_t logsQueueDepth();
+int logsFlush(bool all);
+void logsWakeup();
+#endif
+
 uint32_t sdGetNoSectors();
 uint32_t sdGetSize();
 uint32_t sdGetFreeSectors();
@@ -60,6 +60,18 @@ PACK(typedef struct {
 LogicalSwitchesFlightModeContext lswFm[MAX_FLIGHT_MODES];
 
 #define LS_LAST_VALUE(fm, idx) lswFm[fm].lsw[idx].lastValue
+
+/* Dependency graph of the logical switches. A switch which only reads other
+   logical switches (AND / OR / XOR without delay nor duration, or an unused
+   one) keeps its state as long as none of them has changed since it was last
+   evaluated, all others (sources, physical switches, timers...) are evaluated
+   on each tick */
+typedef uint32_t ls_mask_t;
+ls_mask_t lswDependencies[NUM_LOGICAL_SWITCH];
+ls_mask_t lswAlwaysEvaluated;
+ls_mask_t lswChanged[MAX_FLIGHT_MODES];   // switches changed during the last evaluation of each flight mode
+bool logicalSwitchesGraphValid = false;
+uint16_t logicalSwitchesEvaluated;        // switches evaluated during the last 10ms tick, all flight modes (reset by evalMixes())
         
 #else
 
@@ -541,14 +553,74 @@ bool getSwitch(swsrc_t swtch)
 }
 
 #if defined(CPUARM)
+// returns false if the switch may be something else than a logical switch or a constant
+bool addLogicalSwitchDependency(ls_mask_t & dependencies, swsrc_t swtch)
+{
+  uint8_t idx = abs(swtch);
+  if (idx == SWSRC_NONE || idx == SWSRC_ON) {
+    return true;
+  }
+  else if (idx >= SWSRC_FIRST_LOGICAL_SWITCH && idx <= SWSRC_LAST_LOGICAL_SWITCH) {
+    dependencies |= (ls_mask_t)1 << (idx - SWSRC_FIRST_LOGICAL_SWITCH);
+    return true;
+  }
+  else {
+    return false;
+  }
+}
+
+void buildLogicalSwitchesGraph()
+{
+  lswAlwaysEvaluated = 0;
+  for (unsigned int idx=0; idx<NUM_LOGICAL_SWITCH; idx++) {
+    LogicalSwitchData * ls = lswAddress(idx);
+    ls_mask_t & dependencies = lswDependencies[idx];
+    dependencies = 0;
+    if (ls->delay || ls->duration) {
+      lswAlwaysEvaluated |= (ls_mask_t)1 << idx;
+    }
+    else if (ls->func == LS_FUNC_NONE) {
+      // always false
+    }
+    else if (lswFamily(ls->func) != LS_FAMILY_BOOL ||
+             !addLogicalSwitchDependency(dependencies, ls->andsw) ||
+             !addLogicalSwitchDependency(dependencies, ls->v1) ||
+             !addLogicalSwitchDependency(dependencies, ls->v2)) {
+      lswAlwaysEvaluated |= (ls_mask_t)1 << idx;
+    }
+  }
+  // the switches states may have been computed with the previous model data
+  for (uint8_t fm=0; fm<MAX_FLIGHT_MODES; fm++) {
+    lswChanged[fm] = (ls_mask_t)-1;
+  }
+  logicalSwitchesGraphValid = true;
+}
+
 /**
   @brief Calculates new state of logical switches for mixerCurrentFlightMode
 */
 void evalLogicalSwitches(bool isCurrentPhase)
 {
+  if (!logicalSwitchesGraphValid) {
+    buildLogicalSwitchesGraph();
+  }
+
+  // the logical switches read by a switch may have changed during the previous evaluation
+  // (the ones after it) or during this one (the ones before it)
+  ls_mask_t changedBefore = lswChanged[mixerCurrentFlightMode];
+  ls_mask_t changed = 0;
+
   for (unsigned int idx=0; idx<NUM_LOGICAL_SWITCH; idx++) {
+    ls_mask_t mask = (ls_mask_t)1 << idx;
+    if (!(lswAlwaysEvaluated & mask) && !(changedBefore & mask) && !(lswDependencies[idx] & (changedBefore | changed))) {
+      continue;
+    }
+    logicalSwitchesEvaluated++;
     LogicalSwitchContext & context = lswFm[mixerCurrentFlightMode].lsw[idx];
     bool result = getLogicalSwitch(idx);
+    if (result != context.state) {
+      changed |= mask;
+    }
     if (isCurrentPhase) {
       if (result) {
         if (!context.state) PLAY_LOGICAL_SWITCH_ON(idx);
@@ -559,6 +631,8 @@ void evalLogicalSwitches(bool isCurrentPhase)
     }
     context.state = result;
   }
+
+  lswChanged[mixerCurrentFlightMode] = changed;
 }
 #endif
 
@@ -906,6 +980,7 @@ void logicalSwitchesReset()
 #if defined(CPUARM)
   flightModeTransitionLast = 255;
   memset(lswFm, 0, sizeof(lswFm));
+  logicalSwitchesGraphValid = false;
 #else
   s_last_switch_value = 0;
 #endif
@@ -939,5 +1014,6 @@ getvalue_t convertLswTelemValue(LogicalSwitchData * ls)
 void logicalSwitchesCopyState(uint8_t src, uint8_t dst)
 {
   lswFm[dst] = lswFm[src];
+  lswChanged[dst] = (ls_mask_t)-1;
 }
 #endif
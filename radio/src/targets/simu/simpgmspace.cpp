@@ -55,6 +55,10 @@
   #include <SDL.h>
 #endif
 
+#if defined(CPUARM)
+  #include <chrono>
+#endif
+
 volatile uint8_t pina=0xff, pinb=0xff, pinc=0xff, pind, pine=0xff, pinf=0xff, ping=0xff, pinh=0xff, pinj=0, pinl=0;
 uint8_t portb, portc, porth=0, dummyport;
 uint16_t dummyport16;
@@ -271,6 +275,14 @@ uint16_t getTmr16KHz()
   return get_tmr10ms() * 160;
 }
 
+#if defined(CPUARM)
+profiler_time_t getProfilerTime()
+{
+  // same unit as the 2MHz timer of the radio: 0.5us
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count() / 500;
+}
+#endif
+
 #if !defined(PCBTARANIS)
 bool eeprom_thread_running = true;
 void *eeprom_write_function(void *)
@@ -368,7 +380,9 @@ void *main_thread(void *)
 #if defined(CPUARM)
       doMixerCalculations();
 #if defined(FRSKY) || defined(MAVLINK)
+      PROFILER_START(telemetryTime);
       telemetryWakeup();
+      PROFILER_STOP(PROFILER_STAGE_TELEMETRY, telemetryTime);
 #endif
       checkTrims();
 #endif
@@ -849,6 +863,12 @@ FRESULT f_write (FIL* fil, const void* data, UINT size, UINT* written)
   return FR_OK;
 }
 
+FRESULT f_sync (FIL* fil)
+{
+  if (fil && fil->fs) fflush((FILE*)fil->fs);
+  return FR_OK;
+}
+
 FRESULT f_lseek (FIL* fil, DWORD offset)
 {
   if (fil && fil->fs) fseek((FILE*)fil->fs, offset, SEEK_SET);
@@ -117,10 +117,7 @@ extern "C" void USART6_IRQHandler(void)
 
 void bluetoothWrite(const void * buffer, int len)
 {
-  uint8_t * data = (uint8_t *)buffer;
-  for (int i=0; i<len; ++i) {
-    btTxFifo.push(data[i]);
-  }
+  btTxFifo.push((const uint8_t *)buffer, len);
 }
 
 void bluetoothWriteString(const char * str)
@@ -331,6 +331,7 @@ void hapticOff(void);
 #define DEBUG_BAUDRATE                 115200
 void serial2Init(unsigned int mode, unsigned int protocol);
 void serial2Putc(char c);
+void serial2Write(const uint8_t * data, unsigned int count);
 #define serial2TelemetryInit(protocol) serial2Init(UART_MODE_TELEMETRY, protocol)
 void serial2SbusInit(void);
 void serial2Stop(void);
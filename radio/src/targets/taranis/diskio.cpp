@@ -987,10 +987,13 @@ void sdInit(void)
     referenceSystemAudioFiles();
     
 #if defined(SPORT_FILE_LOG)
-    f_open(&g_telemetryFile, LOGS_PATH "/sport.log", FA_OPEN_ALWAYS | FA_WRITE);
+    f_open(&g_telemetryFile, LOGS_PATH "/sport.otc", FA_OPEN_ALWAYS | FA_WRITE);
     if (f_size(&g_telemetryFile) > 0) {
       f_lseek(&g_telemetryFile, f_size(&g_telemetryFile)); // append
     }
+    else {
+      writeTelemetryCaptureHeader();
+    }
 #endif
   }
 }
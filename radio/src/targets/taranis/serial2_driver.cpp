@@ -103,6 +103,17 @@ void serial2Putc(char c)
   USART_ITConfig(SERIAL_USART, USART_IT_TXE, ENABLE);
 }
 
+void serial2Write(const uint8_t * data, unsigned int count)
+{
+  while (count > 0) {
+    unsigned int len = min<unsigned int>(count, serial2TxFifo.freeSpace());
+    serial2TxFifo.push(data, len);
+    data += len;
+    count -= len;
+    USART_ITConfig(SERIAL_USART, USART_IT_TXE, ENABLE);
+  }
+}
+
 void serial2SbusInit()
 {
   uart3Setup(100000);
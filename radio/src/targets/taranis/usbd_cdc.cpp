@@ -208,10 +208,7 @@ static uint16_t VCP_DataRx (uint8_t* Buf, uint32_t Len)
 
 #if defined(CLI)
   //copy data to the application FIFO
-  for (uint32_t i = 0; i < Len; i++)
-  {
-    cliRxFifo.push(Buf[i]);
-  } 
+  cliRxFifo.push(Buf, Len);
 #endif
 
   return USBD_OK;
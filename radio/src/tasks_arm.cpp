@@ -40,6 +40,7 @@
 #define MIXER_STACK_SIZE       500
 #define AUDIO_STACK_SIZE       500
 #define BLUETOOTH_STACK_SIZE   500
+#define LOGS_STACK_SIZE        500
 
 #if defined(_MSC_VER)
   #define _ALIGNED(x) __declspec(align(x))
@@ -62,6 +63,11 @@ OS_TID btTaskId;
 TaskStack<BLUETOOTH_STACK_SIZE> bluetoothStack;
 #endif
 
+#if defined(SDCARD)
+OS_TID logsTaskId;
+TaskStack<LOGS_STACK_SIZE> logsStack;
+#endif
+
 OS_MutexID audioMutex;
 OS_MutexID mixerMutex;
 
@@ -71,6 +77,7 @@ enum TaskIndex {
   AUDIO_TASK_INDEX,
   CLI_TASK_INDEX,
   BLUETOOTH_TASK_INDEX,
+  LOGS_TASK_INDEX,
   TASK_INDEX_COUNT,
   MAIN_TASK_INDEX = 255
 };
@@ -110,6 +117,9 @@ void stackPaint()
   menusStack.paint();
   mixerStack.paint();
   audioStack.paint();
+#if defined(SDCARD)
+  logsStack.paint();
+#endif
 #if defined(CLI)
   cliStack.paint();
 #endif
@@ -143,7 +153,9 @@ void mixerTask(void * pdata)
       CoLeaveMutexSection(mixerMutex);
 
 #if defined(FRSKY) || defined(MAVLINK)
+      PROFILER_START(telemetryTime);
       telemetryWakeup();
+      PROFILER_STOP(PROFILER_STAGE_TELEMETRY, telemetryTime);
 #endif
 
       if (heartbeat == HEART_WDT_CHECK) {
@@ -205,6 +217,19 @@ void menusTask(void * pdata)
   boardOff(); // Only turn power off if necessary
 }
 
+#if defined(SDCARD)
+#define LOGS_TASK_PERIOD_TICKS      5     // 10ms
+
+// all the logs file accesses are done here, perMain() only formats the rows
+void logsTask(void * pdata)
+{
+  while (1) {
+    logsWakeup();
+    CoTickDelay(LOGS_TASK_PERIOD_TICKS);
+  }
+}
+#endif
+
 extern void audioTask(void* pdata);
 
 void tasksStart()
@@ -222,6 +247,9 @@ void tasksStart()
   mixerTaskId = CoCreateTask(mixerTask, NULL, 5, &mixerStack.stack[MIXER_STACK_SIZE-1], MIXER_STACK_SIZE);
   menusTaskId = CoCreateTask(menusTask, NULL, 10, &menusStack.stack[MENUS_STACK_SIZE-1], MENUS_STACK_SIZE);
   audioTaskId = CoCreateTask(audioTask, NULL, 7, &audioStack.stack[AUDIO_STACK_SIZE-1], AUDIO_STACK_SIZE);
+#if defined(SDCARD)
+  logsTaskId = CoCreateTask(logsTask, NULL, 20, &logsStack.stack[LOGS_STACK_SIZE-1], LOGS_STACK_SIZE);
+#endif
 
 #if !defined(SIMU)
   audioMutex = CoCreateMutex();
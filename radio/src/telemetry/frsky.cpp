@@ -155,40 +155,54 @@ extern uint8_t TrotCount;
 extern uint8_t TezRotary;
 #endif
 
-NOINLINE void processSerialData(uint8_t data)
-{
-  static uint8_t dataState = STATE_DATA_IDLE;
-
-#if defined(BLUETOOTH)
-  // TODO if (g_model.bt_telemetry)
-  btPushByte(data);
-#endif
+uint8_t frskyDataState = STATE_DATA_IDLE;
 
 #if defined(PCBTARANIS)
-    if (g_eeGeneral.serial2Mode == UART_MODE_TELEMETRY_MIRROR) {
-      serial2Putc(data);
-    }
-#endif
+void mirrorSerialData(const uint8_t * data, unsigned int count)
+{
+  if (g_eeGeneral.serial2Mode == UART_MODE_TELEMETRY_MIRROR) {
+    serial2Write(data, count);
+  }
 
-#if defined(PCBTARANIS) && defined(REV9E) && !defined(SIMU)
-    #define BLUETOOTH_BUFFER_LENGTH     20
-    static uint8_t bluetoothBuffer[BLUETOOTH_BUFFER_LENGTH];
-    static uint8_t bluetoothIndex = 0;
-    bluetoothBuffer[bluetoothIndex++] = data;
+#if defined(REV9E) && !defined(SIMU)
+  #define BLUETOOTH_BUFFER_LENGTH     20
+  static uint8_t bluetoothBuffer[BLUETOOTH_BUFFER_LENGTH];
+  static uint8_t bluetoothIndex = 0;
+  while (count > 0) {
+    unsigned int len = min<unsigned int>(count, BLUETOOTH_BUFFER_LENGTH - bluetoothIndex);
+    memcpy(&bluetoothBuffer[bluetoothIndex], data, len);
+    bluetoothIndex += len;
+    data += len;
+    count -= len;
     if (bluetoothIndex == BLUETOOTH_BUFFER_LENGTH) {
       if (bluetoothReady()) {
         bluetoothWrite(bluetoothBuffer, BLUETOOTH_BUFFER_LENGTH);
       }
       bluetoothIndex = 0;
     }
+  }
+#endif
+}
 #endif
 
-  switch (dataState)
+#if defined(FRSKY_SPORT)
+inline void checkSportFrameComplete()
+{
+  if (IS_FRSKY_SPORT_PROTOCOL() && frskyRxBufferCount >= FRSKY_SPORT_PACKET_SIZE) {
+    processSportPacket(frskyRxBuffer);
+    frskyDataState = STATE_DATA_IDLE;
+  }
+}
+#endif
+
+inline void decodeSerialData(uint8_t data)
+{
+  switch (frskyDataState)
   {
     case STATE_DATA_START:
       if (data == START_STOP) {
         if (IS_FRSKY_SPORT_PROTOCOL()) {
-          dataState = STATE_DATA_IN_FRAME ;
+          frskyDataState = STATE_DATA_IN_FRAME ;
           frskyRxBufferCount = 0;
         }
       }
@@ -196,23 +210,23 @@ NOINLINE void processSerialData(uint8_t data)
         if (frskyRxBufferCount < FRSKY_RX_PACKET_SIZE) {
           frskyRxBuffer[frskyRxBufferCount++] = data;
         }
-        dataState = STATE_DATA_IN_FRAME;
+        frskyDataState = STATE_DATA_IN_FRAME;
       }
       break;
 
     case STATE_DATA_IN_FRAME:
       if (data == BYTESTUFF) {
-        dataState = STATE_DATA_XOR; // XOR next byte
+        frskyDataState = STATE_DATA_XOR; // XOR next byte
       }
       else if (data == START_STOP) {
         if (IS_FRSKY_SPORT_PROTOCOL()) {
-          dataState = STATE_DATA_IN_FRAME ;
+          frskyDataState = STATE_DATA_IN_FRAME ;
           frskyRxBufferCount = 0;
         }
         else {
           // end of frame detected
           frskyDProcessPacket(frskyRxBuffer);
-          dataState = STATE_DATA_IDLE;
+          frskyDataState = STATE_DATA_IDLE;
         }
         break;
       }
@@ -225,24 +239,24 @@ NOINLINE void processSerialData(uint8_t data)
       if (frskyRxBufferCount < FRSKY_RX_PACKET_SIZE) {
         frskyRxBuffer[frskyRxBufferCount++] = data ^ STUFF_MASK;
       }
-      dataState = STATE_DATA_IN_FRAME;
+      frskyDataState = STATE_DATA_IN_FRAME;
       break;
 
     case STATE_DATA_IDLE:
       if (data == START_STOP) {
         frskyRxBufferCount = 0;
-        dataState = STATE_DATA_START;
+        frskyDataState = STATE_DATA_START;
       }
 #if defined(TELEMETREZ)
       if (data == PRIVATE) {
-        dataState = STATE_DATA_PRIVATE_LEN;
+        frskyDataState = STATE_DATA_PRIVATE_LEN;
       }
 #endif
       break;
 
 #if defined(TELEMETREZ)
     case STATE_DATA_PRIVATE_LEN:
-      dataState = STATE_DATA_PRIVATE_VALUE;
+      frskyDataState = STATE_DATA_PRIVATE_VALUE;
       privateDataLen = data; // Count of bytes to receive
       privateDataPos = 0;
       break;
@@ -265,19 +279,104 @@ NOINLINE void processSerialData(uint8_t data)
       }
 #endif
       if (++privateDataPos == privateDataLen) {
-        dataState = STATE_DATA_IDLE;
+        frskyDataState = STATE_DATA_IDLE;
       }
       break;
 #endif
   } // switch
 
 #if defined(FRSKY_SPORT)
-  if (IS_FRSKY_SPORT_PROTOCOL() && frskyRxBufferCount >= FRSKY_SPORT_PACKET_SIZE) {
-    processSportPacket(frskyRxBuffer);
-    dataState = STATE_DATA_IDLE;
+  checkSportFrameComplete();
+#endif
+}
+
+NOINLINE void processSerialData(uint8_t data)
+{
+#if defined(BLUETOOTH)
+  // TODO if (g_model.bt_telemetry)
+  btPushByte(data);
+#endif
+
+#if defined(PCBTARANIS)
+  mirrorSerialData(&data, 1);
+#endif
+
+  decodeSerialData(data);
+}
+
+#if defined(PCBTARANIS)
+/* Decodes a span of received bytes. Inside a frame, the bytes up to the next
+   delimiter or stuffed byte are copied at once, only these go through the
+   byte state machine. The state is kept between spans, frames may be split
+*/
+void processSerialSpan(const uint8_t * data, unsigned int count)
+{
+  mirrorSerialData(data, count);
+
+  const uint8_t * end = data + count;
+  while (data < end) {
+    if (frskyDataState == STATE_DATA_IN_FRAME) {
+      unsigned int size = (IS_FRSKY_SPORT_PROTOCOL() ? FRSKY_SPORT_PACKET_SIZE : FRSKY_RX_PACKET_SIZE);
+      while (data < end && frskyRxBufferCount < size && *data != START_STOP && *data != BYTESTUFF) {
+        frskyRxBuffer[frskyRxBufferCount++] = *data++;
+      }
+#if defined(FRSKY_SPORT)
+      checkSportFrameComplete();
+#endif
+      if (data == end) {
+        break;
+      }
+    }
+    decodeSerialData(*data++);
+  }
+}
+
+#if defined(SPORT_FILE_LOG) && !defined(SIMU)
+extern FIL g_telemetryFile;
+tmr10ms_t telemetryCaptureTime;
+
+void writeTelemetryCaptureHeader()
+{
+  uint8_t header[TELEMETRY_CAPTURE_HEADER_SIZE] = { 0, 0, 0, 0, TELEMETRY_CAPTURE_VERSION, TELEMETRY_CAPTURE_SPORT, 0, 0 };
+  memcpy(header, TELEMETRY_CAPTURE_MAGIC, 4);
+  UINT written;
+  f_write(&g_telemetryFile, header, sizeof(header), &written);
+}
+
+void writeTelemetryCaptureRecord(const uint8_t * data, uint8_t count)
+{
+  uint8_t header[TELEMETRY_CAPTURE_RECORD_HEADER];
+  UINT written;
+  tmr10ms_t now = get_tmr10ms();
+  uint32_t delay = (telemetryCaptureTime ? now - telemetryCaptureTime : 0);
+  telemetryCaptureTime = now;
+
+  // long silences are split in empty records
+  while (delay > TELEMETRY_CAPTURE_MAX_DELAY) {
+    header[0] = header[1] = 0xFF;
+    header[2] = 0;
+    f_write(&g_telemetryFile, header, sizeof(header), &written);
+    delay -= TELEMETRY_CAPTURE_MAX_DELAY;
   }
+
+  header[0] = delay;
+  header[1] = delay >> 8;
+  header[2] = count;
+  f_write(&g_telemetryFile, header, sizeof(header), &written);
+  f_write(&g_telemetryFile, data, count, &written);
+}
 #endif
+
+void processTelemetryFifo()
+{
+  const uint8_t * span;
+  uint32_t count;
+  while ((count = telemetryFifo.getSpan(span)) > 0) {
+    processSerialSpan(span, count);
+    telemetryFifo.skip(count);
+  }
 }
+#endif
 
 void telemetryWakeup()
 {
@@ -289,26 +388,18 @@ void telemetryWakeup()
   }
 #endif
 
-#if defined(PCBTARANIS)
-  uint8_t data;
-#if defined(SPORT_FILE_LOG) && !defined(SIMU)
-  static tmr10ms_t lastTime = 0;
-  tmr10ms_t newTime = get_tmr10ms();
-  struct gtm utm;
-  gettime(&utm);
-#endif
-  while (telemetryFifo.pop(data)) {
-    processSerialData(data);
-#if defined(SPORT_FILE_LOG) && !defined(SIMU)
-    extern FIL g_telemetryFile;
-    if (lastTime != newTime) {
-      f_printf(&g_telemetryFile, "\r\n%4d-%02d-%02d,%02d:%02d:%02d.%02d0: %02X", utm.tm_year+1900, utm.tm_mon+1, utm.tm_mday, utm.tm_hour, utm.tm_min, utm.tm_sec, g_ms100, data);
-      lastTime = newTime;
+#if defined(PCBTARANIS) && (!defined(SPORT_FILE_LOG) || defined(SIMU))
+  processTelemetryFifo();
+#elif defined(PCBTARANIS)
+  const uint8_t * span;
+  uint32_t count;
+  while ((count = telemetryFifo.getSpan(span)) > 0) {
+    if (count > TELEMETRY_CAPTURE_MAX_COUNT) {
+      count = TELEMETRY_CAPTURE_MAX_COUNT;
     }
-    else {
-      f_printf(&g_telemetryFile, " %02X", data);
-    }
-#endif
+    writeTelemetryCaptureRecord(span, count);
+    processSerialSpan(span, count);
+    telemetryFifo.skip(count);
   }
 #elif defined(PCBSKY9X)
   if (telemetryProtocol == PROTOCOL_FRSKY_D_SECONDARY) {
@@ -337,12 +428,7 @@ void telemetryWakeup()
 #endif
 
 #if defined(CPUARM)
-  for (int i=0; i<MAX_SENSORS; i++) {
-    const TelemetrySensor & sensor = g_model.telemetrySensors[i];
-    if (sensor.type == TELEM_TYPE_CALCULATED) {
-      telemetryItems[i].eval(sensor);
-    }
-  }
+  evalTelemetrySensors();
 #endif
 
 #if defined(VARIO)
@@ -370,6 +456,7 @@ void telemetryWakeup()
         uint8_t lastReceived = telemetryItems[i].lastReceived;
         if (lastReceived < TELEMETRY_VALUE_TIMER_CYCLE && uint8_t(now - lastReceived) > TELEMETRY_VALUE_OLD_THRESHOLD) {
           telemetryItems[i].lastReceived = TELEMETRY_VALUE_OLD;
+          telemetrySensorUpdated(i);
           TelemetrySensor * sensor = & g_model.telemetrySensors[i];
           if (sensor->unit == UNIT_DATETIME) {
             telemetryItems[i].datetime.datestate = 0;
@@ -505,6 +592,7 @@ void telemetryReset()
   for (int index=0; index<MAX_SENSORS; index++) {
     telemetryItems[index].clear();
   }
+  telemetryHistoryReset();
 #endif
 
   frskyStreaming = 0; // reset counter only if valid frsky packets are being detected
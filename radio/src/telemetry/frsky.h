@@ -524,8 +524,26 @@ void frskyDProcessPacket(uint8_t *packet);
 // FrSky S.PORT Protocol
 void processSportPacket(uint8_t *packet);
 #if defined(PCBTARANIS)
+extern Fifo<512> telemetryFifo;
+void processSerialSpan(const uint8_t * data, unsigned int count);
+void processTelemetryFifo();
 void sportFirmwareUpdate(ModuleIndex module, const char *filename);
 #endif
+
+// Telemetry capture files (.otc), written with SPORT_FILE_LOG and replayed by the Companion telemetry simulator.
+// A header is followed by records of raw bytes: the delay since the previous record (uint16, 10ms ticks),
+// the bytes count (uint8) and the bytes as received from the module
+#define TELEMETRY_CAPTURE_MAGIC          "OTXC"
+#define TELEMETRY_CAPTURE_VERSION        1
+#define TELEMETRY_CAPTURE_HEADER_SIZE    8
+#define TELEMETRY_CAPTURE_SPORT          0
+#define TELEMETRY_CAPTURE_RECORD_HEADER  3
+#define TELEMETRY_CAPTURE_MAX_DELAY      0xFFFF
+#define TELEMETRY_CAPTURE_MAX_COUNT      0xFF
+#if defined(SPORT_FILE_LOG) && !defined(SIMU)
+void writeTelemetryCaptureHeader();
+void writeTelemetryCaptureRecord(const uint8_t * data, uint8_t count);
+#endif
 void telemetryWakeup(void);
 void telemetryReset();
 void telemetryInit(void);
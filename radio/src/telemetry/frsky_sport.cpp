@@ -56,46 +56,52 @@ struct FrSkySportSensor {
   const uint8_t prec;
 };
 
+// sorted by firstId, the ranges don't overlap
 const FrSkySportSensor sportSensors[] = {
-  { RSSI_ID, RSSI_ID, ZSTR_RSSI, UNIT_DB, 0 },
-  { SWR_ID, SWR_ID, ZSTR_SWR, UNIT_RAW, 0 },
-  { ADC1_ID, ADC1_ID, ZSTR_A1, UNIT_VOLTS, 1 },
-  { ADC2_ID, ADC2_ID, ZSTR_A2, UNIT_VOLTS, 1 },
-  { A3_FIRST_ID, A3_LAST_ID, ZSTR_A3, UNIT_VOLTS, 2 },
-  { A4_FIRST_ID, A4_LAST_ID, ZSTR_A4, UNIT_VOLTS, 2 },  
-  { BATT_ID, BATT_ID, ZSTR_BATT, UNIT_VOLTS, 1 },
+  { ALT_FIRST_ID, ALT_LAST_ID, ZSTR_ALT, UNIT_METERS, 2 },
+  { VARIO_FIRST_ID, VARIO_LAST_ID, ZSTR_VSPD, UNIT_METERS_PER_SECOND, 2 },
+  { CURR_FIRST_ID, CURR_LAST_ID, ZSTR_CURR, UNIT_AMPS, 1 },
+  { VFAS_FIRST_ID, VFAS_LAST_ID, ZSTR_VFAS, UNIT_VOLTS, 2 },
+  { CELLS_FIRST_ID, CELLS_LAST_ID, ZSTR_CELLS, UNIT_CELLS, 2 },
   { T1_FIRST_ID, T1_LAST_ID, ZSTR_TEMP1, UNIT_CELSIUS, 0 },
   { T2_FIRST_ID, T2_LAST_ID, ZSTR_TEMP2, UNIT_CELSIUS, 0 },
   { RPM_FIRST_ID, RPM_LAST_ID, ZSTR_RPM, UNIT_RPMS, 0 },
   { FUEL_FIRST_ID, FUEL_LAST_ID, ZSTR_FUEL, UNIT_PERCENT, 0 },
-  { ALT_FIRST_ID, ALT_LAST_ID, ZSTR_ALT, UNIT_METERS, 2 },
-  { VARIO_FIRST_ID, VARIO_LAST_ID, ZSTR_VSPD, UNIT_METERS_PER_SECOND, 2 },
   { ACCX_FIRST_ID, ACCX_LAST_ID, ZSTR_ACCX, UNIT_G, 2 },
   { ACCY_FIRST_ID, ACCY_LAST_ID, ZSTR_ACCY, UNIT_G, 2 },
   { ACCZ_FIRST_ID, ACCZ_LAST_ID, ZSTR_ACCZ, UNIT_G, 2 },
-  { CURR_FIRST_ID, CURR_LAST_ID, ZSTR_CURR, UNIT_AMPS, 1 },
-  { VFAS_FIRST_ID, VFAS_LAST_ID, ZSTR_VFAS, UNIT_VOLTS, 2 },
-  { AIR_SPEED_FIRST_ID, AIR_SPEED_LAST_ID, ZSTR_ASPD, UNIT_KMH, 1 },
-  { GPS_SPEED_FIRST_ID, GPS_SPEED_LAST_ID, ZSTR_GSPD, UNIT_KTS, 3 },
-  { CELLS_FIRST_ID, CELLS_LAST_ID, ZSTR_CELLS, UNIT_CELLS, 2 },
+  { GPS_LONG_LATI_FIRST_ID, GPS_LONG_LATI_LAST_ID, ZSTR_GPS, UNIT_GPS, 0 },
   { GPS_ALT_FIRST_ID, GPS_ALT_LAST_ID, ZSTR_GPSALT, UNIT_METERS, 2 },
+  { GPS_SPEED_FIRST_ID, GPS_SPEED_LAST_ID, ZSTR_GSPD, UNIT_KTS, 3 },
+  { GPS_COURS_FIRST_ID, GPS_COURS_LAST_ID, ZSTR_HDG, UNIT_DEGREE, 2 },
   { GPS_TIME_DATE_FIRST_ID, GPS_TIME_DATE_LAST_ID, ZSTR_GPSDATETIME, UNIT_DATETIME, 0 },
-  { GPS_LONG_LATI_FIRST_ID, GPS_LONG_LATI_LAST_ID, ZSTR_GPS, UNIT_GPS, 0 },
+  { A3_FIRST_ID, A3_LAST_ID, ZSTR_A3, UNIT_VOLTS, 2 },
+  { A4_FIRST_ID, A4_LAST_ID, ZSTR_A4, UNIT_VOLTS, 2 },
+  { AIR_SPEED_FIRST_ID, AIR_SPEED_LAST_ID, ZSTR_ASPD, UNIT_KMH, 1 },
   { FUEL_QTY_FIRST_ID, FUEL_QTY_LAST_ID, ZSTR_FUEL, UNIT_MILLILITERS, 2 },
-  { GPS_COURS_FIRST_ID, GPS_COURS_LAST_ID, ZSTR_HDG, UNIT_DEGREE, 2 },
-  { 0, 0, NULL, UNIT_RAW, 0 } // sentinel
+  { RSSI_ID, RSSI_ID, ZSTR_RSSI, UNIT_DB, 0 },
+  { ADC1_ID, ADC1_ID, ZSTR_A1, UNIT_VOLTS, 1 },
+  { ADC2_ID, ADC2_ID, ZSTR_A2, UNIT_VOLTS, 1 },
+  { BATT_ID, BATT_ID, ZSTR_BATT, UNIT_VOLTS, 1 },
+  { SWR_ID, SWR_ID, ZSTR_SWR, UNIT_RAW, 0 },
 };
 
 const FrSkySportSensor * getFrSkySportSensor(uint16_t id)
 {
-  const FrSkySportSensor * result = NULL;
-  for (const FrSkySportSensor * sensor = sportSensors; sensor->firstId; sensor++) {
-    if (id >= sensor->firstId && id <= sensor->lastId) {
-      result = sensor;
-      break;
-    }
+  // binary search of the last range starting at or before id
+  int first = 0;
+  int last = DIM(sportSensors) - 1;
+  while (first <= last) {
+    int middle = (first + last) / 2;
+    const FrSkySportSensor * sensor = &sportSensors[middle];
+    if (id < sensor->firstId)
+      last = middle - 1;
+    else if (id > sensor->lastId)
+      first = middle + 1;
+    else
+      return sensor;
   }
-  return result;
+  return NULL;
 }
 
 bool checkSportPacket(uint8_t *packet)
@@ -305,10 +311,7 @@ bool sportWaitState(SportUpdateState state, int timeout)
     return true;
 #else
   for (int i=timeout/2; i>=0; i--) {
-    uint8_t data ;
-    while (telemetryFifo.pop(data)) {
-      processSerialData(data);
-    }
+    processTelemetryFifo();
     if (sportUpdateState == state) {
       return true;
     }
@@ -5,12 +5,9 @@ uint8_t allowNewSensors;
 
 void TelemetryItem::gpsReceived()
 {
-  if (!distFromEarthAxis) {
-    gps.extractLatitudeLongitude(&pilotLatitude, &pilotLongitude);
-    uint32_t lat = pilotLatitude / 10000;
-    uint32_t angle2 = (lat*lat) / 10000;
-    uint32_t angle4 = angle2 * angle2;
-    distFromEarthAxis = 139*(((uint32_t)10000000-((angle2*(uint32_t)123370)/81)+(angle4/25))/12500);
+  if (!pilotLongitudeScale) {
+    gps.getPosition(&pilotLatitude, &pilotLongitude);
+    pilotLongitudeScale = max<uint32_t>(1, gpsLongitudeScale(pilotLatitude));
   }
   lastReceived = now();
 }
@@ -19,6 +16,8 @@ void TelemetryItem::setValue(const TelemetrySensor & sensor, int32_t val, uint32
 {
   int32_t newVal = val;
 
+  telemetrySensorUpdated(this - telemetryItems);
+
   if (unit == UNIT_CELLS) {
     uint32_t data = uint32_t(newVal);
     uint8_t cellsCount = (data >> 24);
@@ -239,6 +238,8 @@ void TelemetryItem::setValue(const TelemetrySensor & sensor, int32_t val, uint32
 
   value = newVal;
   lastReceived = now();
+
+  telemetryHistoryAddSample(this - telemetryItems, newVal);
 }
 
 bool TelemetryItem::isAvailable()
@@ -354,23 +355,33 @@ void TelemetryItem::eval(const TelemetrySensor & sensor)
             return;
           }
         }
-        uint32_t latitude, longitude;
-        gpsItem.gps.extractLatitudeLongitude(&latitude, &longitude);
-
-        uint32_t angle = (latitude > gpsItem.pilotLatitude) ? latitude - gpsItem.pilotLatitude : gpsItem.pilotLatitude - latitude;
-        uint32_t dist = EARTH_RADIUS * angle / 1000000;
-        uint32_t result = dist*dist;
-
-        angle = (longitude > gpsItem.pilotLongitude) ? longitude - gpsItem.pilotLongitude : gpsItem.pilotLongitude - longitude;
-        dist = gpsItem.distFromEarthAxis * angle / 1000000;
-        result += dist*dist;
+        int32_t latitude, longitude, east, north;
+        gpsItem.gps.getPosition(&latitude, &longitude);
+        gpsGetOffset(gpsItem.pilotLatitude, gpsItem.pilotLongitude, gpsItem.pilotLongitudeScale, latitude, longitude, &east, &north);
 
+        int32_t height = 0;
         if (altItem) {
-          dist = abs(altItem->value) / g_model.telemetrySensors[sensor.dist.alt-1].getPrecDivisor();
-          result += dist*dist;
+          height = altItem->value / g_model.telemetrySensors[sensor.dist.alt-1].getPrecDivisor();
         }
 
-        setValue(sensor, isqrt32(result), UNIT_METERS);
+        setValue(sensor, gpsGetDistance(east, north, height), UNIT_METERS);
+      }
+      break;
+
+    case TELEM_FORMULA_BEARING:
+      if (sensor.dist.gps) {
+        TelemetryItem & gpsItem = telemetryItems[sensor.dist.gps-1];
+        if (!gpsItem.isAvailable()) {
+          return;
+        }
+        else if (gpsItem.isOld()) {
+          lastReceived = TELEMETRY_VALUE_OLD;
+          return;
+        }
+        int32_t latitude, longitude, east, north;
+        gpsItem.gps.getPosition(&latitude, &longitude);
+        gpsGetOffset(gpsItem.pilotLatitude, gpsItem.pilotLongitude, gpsItem.pilotLongitudeScale, latitude, longitude, &east, &north);
+        setValue(sensor, gpsGetBearing(east, north), UNIT_DEGREE);
       }
       break;
 
@@ -455,6 +466,7 @@ void delTelemetryIndex(uint8_t index)
 {
   memclear(&g_model.telemetrySensors[index], sizeof(TelemetrySensor));
   telemetryItems[index].clear();
+  telemetryHistoryClear(index);
   eeDirty(EE_MODEL);
 }
 
@@ -480,19 +492,231 @@ int lastUsedTelemetryIndex()
   return -1;
 }
 
-void setTelemetryValue(TelemetryProtocol protocol, uint16_t id, uint8_t instance, int32_t value, uint32_t unit, uint32_t prec)
+/* Open addressed (id, instance) table of the custom sensors, each entry is the head
+   of the list of the sensors sharing the same id and instance, in index order.
+   It is rebuilt on the next received value after the model has been modified
+*/
+#define TELEMETRY_INDEX_SIZE   (2*MAX_SENSORS)
+
+struct TelemetryIndexEntry {
+  uint16_t id;
+  uint8_t instance;
+  int8_t first;   // -1 when the entry is empty
+};
+
+TelemetryIndexEntry telemetryIndex[TELEMETRY_INDEX_SIZE];
+int8_t telemetryIndexNext[MAX_SENSORS];
+bool telemetryIndexValid = false;
+
+inline unsigned int telemetryIndexHash(uint16_t id, uint8_t instance)
 {
-  bool available = false;
+  uint16_t hash = (id * 31) ^ (instance * 97);
+  return (hash ^ (hash >> 6)) & (TELEMETRY_INDEX_SIZE-1);
+}
+
+TelemetryIndexEntry * getTelemetryIndexEntry(uint16_t id, uint8_t instance)
+{
+  if (g_model.ignoreSensorIds) {
+    instance = 0;
+  }
+  unsigned int i = telemetryIndexHash(id, instance);
+  while (true) {
+    TelemetryIndexEntry * entry = &telemetryIndex[i];
+    if (entry->first < 0 || (entry->id == id && entry->instance == instance)) {
+      // there are at most MAX_SENSORS entries used, an empty one is always found
+      return entry;
+    }
+    i = (i + 1) & (TELEMETRY_INDEX_SIZE-1);
+  }
+}
+
+/* The calculated sensors are only evaluated when one of their sources has received
+   a new value (or became old). Their sources and dependents are bitmasks of sensors,
+   and they are evaluated in dependency order, the sources first, so that a chain
+   of calculated sensors is updated in a single pass. The formulas and sources they
+   were computed from are kept, so that any change of the model is detected, even
+   without eeDirty()
+*/
+#if MAX_SENSORS > 32
+  #error "The telemetry sensors bitmasks have to be extended"
+#endif
+
+uint32_t telemetryEvalSources[MAX_SENSORS];
+uint32_t telemetryEvalDependents[MAX_SENSORS];
+uint32_t telemetryEvalPending = 0;
+uint8_t telemetryEvalOrder[MAX_SENSORS];
+uint8_t telemetryEvalCount = 0;
+uint8_t telemetryEvalFormulas[MAX_SENSORS];
+uint32_t telemetryEvalParams[MAX_SENSORS];
+
+#define TELEMETRY_EVAL_NONE    0xff
+
+inline uint8_t getTelemetryEvalFormula(const TelemetrySensor & sensor)
+{
+  return (sensor.type == TELEM_TYPE_CALCULATED ? sensor.formula : TELEMETRY_EVAL_NONE);
+}
+
+bool isTelemetryEvalOrderValid()
+{
+  for (int index=0; index<MAX_SENSORS; index++) {
+    TelemetrySensor & sensor = g_model.telemetrySensors[index];
+    uint8_t formula = getTelemetryEvalFormula(sensor);
+    if (formula != telemetryEvalFormulas[index] || (formula != TELEMETRY_EVAL_NONE && sensor.param != telemetryEvalParams[index])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void addTelemetryEvalSource(uint8_t index, int source)
+{
+  if (source && abs(source) <= MAX_SENSORS) {
+    source = abs(source) - 1;
+    telemetryEvalSources[index] |= (uint32_t)1 << source;
+    telemetryEvalDependents[source] |= (uint32_t)1 << index;
+  }
+}
+
+void updateTelemetryEvalOrder()
+{
+  uint32_t remaining = 0;
+
+  memclear(telemetryEvalSources, sizeof(telemetryEvalSources));
+  memclear(telemetryEvalDependents, sizeof(telemetryEvalDependents));
 
   for (int index=0; index<MAX_SENSORS; index++) {
+    TelemetrySensor & sensor = g_model.telemetrySensors[index];
+    telemetryEvalFormulas[index] = getTelemetryEvalFormula(sensor);
+    telemetryEvalParams[index] = sensor.param;
+    if (sensor.type == TELEM_TYPE_CALCULATED) {
+      switch (sensor.formula) {
+        case TELEM_FORMULA_CELL:
+          addTelemetryEvalSource(index, sensor.cell.source);
+          break;
+        case TELEM_FORMULA_DIST:
+          addTelemetryEvalSource(index, sensor.dist.gps);
+          addTelemetryEvalSource(index, sensor.dist.alt);
+          break;
+        case TELEM_FORMULA_BEARING:
+          addTelemetryEvalSource(index, sensor.dist.gps);
+          break;
+        case TELEM_FORMULA_ADD:
+        case TELEM_FORMULA_AVERAGE:
+        case TELEM_FORMULA_MIN:
+        case TELEM_FORMULA_MAX:
+        case TELEM_FORMULA_MULTIPLY:
+          for (int i=0; i<(sensor.formula == TELEM_FORMULA_MULTIPLY ? 2 : 4); i++) {
+            addTelemetryEvalSource(index, sensor.calc.sources[i]);
+          }
+          break;
+        default:
+          // not evaluated in eval()
+          continue;
+      }
+      remaining |= (uint32_t)1 << index;
+    }
+  }
+
+  // everything is evaluated once after a model change
+  telemetryEvalPending = remaining;
+
+  telemetryEvalCount = 0;
+  while (remaining) {
+    bool progress = false;
+    for (int index=0; index<MAX_SENSORS; index++) {
+      uint32_t mask = (uint32_t)1 << index;
+      if ((remaining & mask) && !(telemetryEvalSources[index] & remaining)) {
+        telemetryEvalOrder[telemetryEvalCount++] = index;
+        remaining &= ~mask;
+        progress = true;
+      }
+    }
+    if (!progress) {
+      // circular references, these ones are evaluated in index order
+      for (int index=0; index<MAX_SENSORS; index++) {
+        if (remaining & ((uint32_t)1 << index)) {
+          telemetryEvalOrder[telemetryEvalCount++] = index;
+        }
+      }
+      break;
+    }
+  }
+}
+
+void updateTelemetryIndex()
+{
+  for (int i=0; i<TELEMETRY_INDEX_SIZE; i++) {
+    telemetryIndex[i].first = -1;
+  }
+
+  for (int index=MAX_SENSORS-1; index>=0; index--) {
     TelemetrySensor & telemetrySensor = g_model.telemetrySensors[index];
-    if (telemetrySensor.type == TELEM_TYPE_CUSTOM && telemetrySensor.id == id && (telemetrySensor.instance == instance || g_model.ignoreSensorIds)) {
-      telemetryItems[index].setValue(telemetrySensor, value, unit, prec);
-      available = true;
-      // we continue search here, because sensors can share the same id and instance
+    telemetryIndexNext[index] = -1;
+    if (telemetrySensor.type == TELEM_TYPE_CUSTOM) {
+      TelemetryIndexEntry * entry = getTelemetryIndexEntry(telemetrySensor.id, telemetrySensor.instance);
+      if (entry->first < 0) {
+        entry->id = telemetrySensor.id;
+        entry->instance = (g_model.ignoreSensorIds ? 0 : telemetrySensor.instance);
+      }
+      else {
+        telemetryIndexNext[index] = entry->first;
+      }
+      entry->first = index;
     }
   }
 
+  updateTelemetryEvalOrder();
+
+  telemetryIndexValid = true;
+}
+
+void telemetrySensorUpdated(uint8_t index)
+{
+  if (!telemetryIndexValid) {
+    updateTelemetryIndex();
+  }
+  telemetryEvalPending |= telemetryEvalDependents[index];
+}
+
+void evalTelemetrySensors()
+{
+  if (!telemetryIndexValid) {
+    updateTelemetryIndex();
+  }
+  else if (!isTelemetryEvalOrderValid()) {
+    updateTelemetryEvalOrder();
+  }
+
+  for (int i=0; i<telemetryEvalCount && telemetryEvalPending; i++) {
+    uint8_t index = telemetryEvalOrder[i];
+    uint32_t mask = (uint32_t)1 << index;
+    if (telemetryEvalPending & mask) {
+      telemetryEvalPending &= ~mask;
+      TelemetryItem & item = telemetryItems[index];
+      uint8_t lastReceived = item.lastReceived;
+      item.eval(g_model.telemetrySensors[index]);
+      if (item.isOld() && lastReceived != TELEMETRY_VALUE_OLD) {
+        // no setValue() when a sensor becomes old, its dependents are notified here
+        telemetryEvalPending |= telemetryEvalDependents[index];
+      }
+    }
+  }
+}
+
+void setTelemetryValue(TelemetryProtocol protocol, uint16_t id, uint8_t instance, int32_t value, uint32_t unit, uint32_t prec)
+{
+  if (!telemetryIndexValid) {
+    updateTelemetryIndex();
+  }
+
+  bool available = false;
+
+  // sensors can share the same id and instance
+  for (int index=getTelemetryIndexEntry(id, instance)->first; index>=0; index=telemetryIndexNext[index]) {
+    telemetryItems[index].setValue(g_model.telemetrySensors[index], value, unit, prec);
+    available = true;
+  }
+
   if (available || !allowNewSensors) {
     return;
   }
@@ -520,6 +744,150 @@ void setTelemetryValue(TelemetryProtocol protocol, uint16_t id, uint8_t instance
   }
 }
 
+TelemetryHistory telemetryHistory[TELEMETRY_HISTORY_SLOTS];
+
+TelemetryHistory * findTelemetryHistory(uint8_t index)
+{
+  for (int i=0; i<TELEMETRY_HISTORY_SLOTS; i++) {
+    if (telemetryHistory[i].sensor == index+1) {
+      return &telemetryHistory[i];
+    }
+  }
+  return NULL;
+}
+
+void telemetryHistoryClear(uint8_t index)
+{
+  TelemetryHistory * history = findTelemetryHistory(index);
+  if (history) {
+    memclear(history, sizeof(TelemetryHistory));
+  }
+}
+
+void telemetryHistoryReset()
+{
+  memclear(telemetryHistory, sizeof(telemetryHistory));
+}
+
+static void telemetryHistoryAccumulate(TelemetryHistoryLevel & level, tmr10ms_t time, int32_t min, int32_t max, int64_t sum, uint32_t samples)
+{
+  if (!level.samples) {
+    level.start = time;
+    level.min = min;
+    level.max = max;
+  }
+  else {
+    if (min < level.min) level.min = min;
+    if (max > level.max) level.max = max;
+  }
+  level.sum += sum;
+  level.samples += samples;
+}
+
+static TelemetryHistoryBucket & telemetryHistoryClose(TelemetryHistoryLevel & level)
+{
+  TelemetryHistoryBucket & bucket = level.buckets[level.head];
+  bucket.time = level.start;
+  bucket.min = level.min;
+  bucket.max = level.max;
+  bucket.avg = level.sum / (int32_t)level.samples;
+  level.head = (level.head + 1) % TELEMETRY_HISTORY_BUCKETS;
+  if (level.count < TELEMETRY_HISTORY_BUCKETS) {
+    level.count++;
+  }
+  level.sum = 0;
+  level.samples = 0;
+  return bucket;
+}
+
+void telemetryHistoryAddSample(uint8_t index, int32_t value)
+{
+  TelemetryHistory * history = findTelemetryHistory(index);
+
+  if (!g_model.telemetrySensors[index].history) {
+    if (history) {
+      memclear(history, sizeof(TelemetryHistory));
+    }
+    return;
+  }
+
+  if (!history) {
+    for (int i=0; i<TELEMETRY_HISTORY_SLOTS; i++) {
+      if (telemetryHistory[i].sensor == 0) {
+        history = &telemetryHistory[i];
+        history->sensor = index+1;
+        break;
+      }
+    }
+    if (!history) {
+      // all slots are in use
+      return;
+    }
+  }
+
+  tmr10ms_t now = get_tmr10ms();
+
+  history->rawTimes[history->rawHead] = now;
+  history->rawValues[history->rawHead] = value;
+  history->rawHead = (history->rawHead + 1) % TELEMETRY_HISTORY_RAW_SIZE;
+  if (history->rawCount < TELEMETRY_HISTORY_RAW_SIZE) {
+    history->rawCount++;
+  }
+
+  // the 10s buckets are fed with the 1s buckets when they are closed
+  TelemetryHistoryLevel & seconds = history->levels[TELEMETRY_HISTORY_1S-1];
+  if (seconds.samples && now - seconds.start >= 100) {
+    TelemetryHistoryLevel & tens = history->levels[TELEMETRY_HISTORY_10S-1];
+    int64_t sum = seconds.sum;
+    uint32_t samples = seconds.samples;
+    TelemetryHistoryBucket & bucket = telemetryHistoryClose(seconds);
+    if (tens.samples && bucket.time - tens.start >= 1000) {
+      telemetryHistoryClose(tens);
+    }
+    telemetryHistoryAccumulate(tens, bucket.time, bucket.min, bucket.max, sum, samples);
+  }
+  telemetryHistoryAccumulate(seconds, now, value, value, value, 1);
+}
+
+uint8_t readTelemetryHistory(uint8_t index, uint8_t resolution, TelemetryHistoryBucket * buckets, uint8_t count)
+{
+  TelemetryHistory * history = findTelemetryHistory(index);
+  if (!history || resolution >= TELEMETRY_HISTORY_RESOLUTIONS) {
+    return 0;
+  }
+
+  // buckets are returned oldest first
+  if (resolution == TELEMETRY_HISTORY_RAW) {
+    uint8_t result = min<uint8_t>(count, history->rawCount);
+    for (int i=0; i<result; i++) {
+      int pos = (history->rawHead + TELEMETRY_HISTORY_RAW_SIZE - result + i) % TELEMETRY_HISTORY_RAW_SIZE;
+      buckets[i].time = history->rawTimes[pos];
+      buckets[i].min = buckets[i].max = buckets[i].avg = history->rawValues[pos];
+    }
+    return result;
+  }
+
+  // the bucket being filled comes last
+  TelemetryHistoryLevel & level = history->levels[resolution-1];
+  uint8_t open = (level.samples ? 1 : 0);
+  uint8_t result = min<uint8_t>(count, level.count + open);
+  int closed = result - open;
+  if (closed < 0) {
+    closed = 0;
+  }
+  for (int i=0; i<closed; i++) {
+    buckets[i] = level.buckets[(level.head + TELEMETRY_HISTORY_BUCKETS - closed + i) % TELEMETRY_HISTORY_BUCKETS];
+  }
+  if (closed < result) {
+    TelemetryHistoryBucket & bucket = buckets[closed];
+    bucket.time = level.start;
+    bucket.min = level.min;
+    bucket.max = level.max;
+    bucket.avg = level.sum / (int32_t)level.samples;
+  }
+  return result;
+}
+
 void TelemetrySensor::init(const char * label, uint8_t unit, uint8_t prec)
 {
   memclear(this->label, TELEM_LABEL_LEN);
@@ -81,17 +81,17 @@ class TelemetryItem
   public:
     union {
       int32_t  value;           // value, stored as uint32_t but interpreted accordingly to type
-      uint32_t distFromEarthAxis;
+      uint32_t pilotLongitudeScale;
     };
 
     union {
       int32_t  valueMin;        // min store
-      uint32_t pilotLongitude;
+      int32_t  pilotLongitude;
     };
 
     union {
       int32_t  valueMax;        // max store
-      uint32_t pilotLatitude;
+      int32_t  pilotLatitude;
     };
 
     uint8_t lastReceived;       // for detection of sensor loss
@@ -127,7 +127,7 @@ class TelemetryItem
         char     latitudeNS;
         // pilot longitude is stored in min
         // pilot latitude is stored in max
-        // distFromEarthAxis is stored in value
+        // pilot longitude scale is stored in value
         void extractLatitudeLongitude(uint32_t * latitude, uint32_t * longitude)
         {
           div_t qr = div(latitude_bp, 100);
@@ -135,6 +135,14 @@ class TelemetryItem
           qr = div(longitude_bp, 100);
           *longitude = ((uint32_t)(qr.quot) * 1000000) + (((uint32_t)(qr.rem) * 10000 + longitude_ap) * 5) / 3;
         }
+        // signed position, positive North / East
+        void getPosition(int32_t * latitude, int32_t * longitude)
+        {
+          uint32_t lat, lng;
+          extractLatitudeLongitude(&lat, &lng);
+          *latitude = (latitudeNS == 'S' ? -(int32_t)lat : (int32_t)lat);
+          *longitude = (longitudeEW == 'W' ? -(int32_t)lng : (int32_t)lng);
+        }
       } gps;
     };
 
@@ -183,6 +191,67 @@ inline bool isTelemetryFieldComparisonAvailable(int index)
   return (sensor.id != 0);
 }
 
+extern bool telemetryIndexValid;
+#define INVALIDATE_TELEMETRY_INDEX() telemetryIndexValid = false
+
+void telemetrySensorUpdated(uint8_t index);
+void evalTelemetrySensors();
+
+// Sensor history: the sensors with the history option get one of the slots
+// below on their first sample. Each slot keeps the last raw samples and two
+// rings of 1s and 10s min/max/avg buckets, the 10s ones being built from the
+// closed 1s buckets.
+#if defined(PCBTARANIS)
+  #define TELEMETRY_HISTORY_SLOTS      4
+#else
+  #define TELEMETRY_HISTORY_SLOTS      2
+#endif
+#define TELEMETRY_HISTORY_RAW_SIZE     32
+#define TELEMETRY_HISTORY_BUCKETS      32
+
+enum TelemetryHistoryResolution {
+  TELEMETRY_HISTORY_RAW,
+  TELEMETRY_HISTORY_1S,
+  TELEMETRY_HISTORY_10S,
+  TELEMETRY_HISTORY_RESOLUTIONS
+};
+
+struct TelemetryHistoryBucket {
+  tmr10ms_t time;
+  int32_t   min;
+  int32_t   max;
+  int32_t   avg;
+};
+
+struct TelemetryHistoryLevel {
+  TelemetryHistoryBucket buckets[TELEMETRY_HISTORY_BUCKETS];
+  uint8_t   head;
+  uint8_t   count;
+  // bucket being filled
+  tmr10ms_t start;
+  int32_t   min;
+  int32_t   max;
+  int64_t   sum;
+  uint32_t  samples;
+};
+
+struct TelemetryHistory {
+  uint8_t   sensor;  // sensor index + 1, 0 when the slot is free
+  uint8_t   rawHead;
+  uint8_t   rawCount;
+  tmr10ms_t rawTimes[TELEMETRY_HISTORY_RAW_SIZE];
+  int32_t   rawValues[TELEMETRY_HISTORY_RAW_SIZE];
+  TelemetryHistoryLevel levels[TELEMETRY_HISTORY_RESOLUTIONS-1];
+};
+
+extern TelemetryHistory telemetryHistory[TELEMETRY_HISTORY_SLOTS];
+
+void telemetryHistoryAddSample(uint8_t index, int32_t value);
+void telemetryHistoryClear(uint8_t index);
+void telemetryHistoryReset();
+TelemetryHistory * findTelemetryHistory(uint8_t index);
+uint8_t readTelemetryHistory(uint8_t index, uint8_t resolution, TelemetryHistoryBucket * buckets, uint8_t count);
+
 void setTelemetryValue(TelemetryProtocol protocol, uint16_t id, uint8_t instance, int32_t value, uint32_t unit, uint32_t prec);
 void delTelemetryIndex(uint8_t index);
 int availableTelemetryIndex();
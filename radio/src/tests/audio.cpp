@@ -0,0 +1,365 @@
+/*
+ * Authors (alphabetical order)
+ * - Andre Bernet <bernet.andre@gmail.com>
+ * - Andreas Weitl
+ * - Bertrand Songis <bsongis@gmail.com>
+ * - Bryan J. Rentoul (Gruvin) <gruvin@gmail.com>
+ * - Cameron Weeks <th9xer@gmail.com>
+ * - Erez Raviv
+ * - Gabriel Birkus
+ * - Jean-Pierre Parisy
+ * - Karl Szmutny
+ * - Michael Blandford
+ * - Michal Hlavinka
+ * - Pat Mackenzie
+ * - Philip Moss
+ * - Rob Thomson
+ * - Romolo Manfredini <romolo.manfredini@gmail.com>
+ * - Thomas Husterer
+ *
+ * opentx is based on code named
+ * gruvin9x by Bryan J. Rentoul: http://code.google.com/p/gruvin9x/,
+ * er9x by Erez Raviv: http://code.google.com/p/er9x/,
+ * and the original (and ongoing) project by
+ * Thomas Husterer, th9x: http://code.google.com/p/th9x/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include "gtests.h"
+#include "opentx.h"
+
+#if defined(CPUARM)
+extern const int16_t sineValues[1024];
+
+// the former double precision tone synthesis, as the reference
+struct ReferenceTone {
+  uint16_t freq;
+  uint16_t duration;
+  int8_t   freqIncr;
+  uint16_t stateFreq;
+  uint16_t stateDuration;
+  double   step;
+  double   idx;
+  float    volume;
+};
+
+// the samples where the double phase is too close to an entry boundary can take the 2 values
+void renderReferenceTone(ReferenceTone & tone, int volume, int16_t * low, int16_t * high)
+{
+  const unsigned int toneVolumes[] = { 10, 8, 6, 4, 2 };
+  int remainingDuration = tone.duration - tone.stateDuration;
+  if (remainingDuration <= 0) {
+    return;
+  }
+
+  if (tone.freq != tone.stateFreq) {
+    tone.stateFreq = tone.freq;
+    tone.step = double(DIM(sineValues)*tone.freq) / AUDIO_SAMPLE_RATE;
+    tone.volume = toneVolumes[2+volume];
+    if (tone.freq < 330) {
+      tone.volume = (tone.volume * tone.freq * tone.freq) / (330 * 330);
+    }
+  }
+
+  if (tone.freqIncr) {
+    tone.freq += AUDIO_BUFFER_DURATION * tone.freqIncr;
+  }
+
+  double toneIdx = tone.idx;
+  int minPoints = AUDIO_BUFFER_SIZE;
+  int points = AUDIO_BUFFER_SIZE;
+  if (remainingDuration <= AUDIO_BUFFER_DURATION) {
+    // the tone end is rounded to a period end, which is also ambiguous
+    int count = (remainingDuration * AUDIO_BUFFER_SIZE) / AUDIO_BUFFER_DURATION;
+    minPoints = AUDIO_BUFFER_SIZE;
+    points = 0;
+    for (int j=-1; j<=1; j+=2) {
+      unsigned int end = toneIdx + (tone.step * count) + j*1e-6;
+      if (end > DIM(sineValues))
+        end -= (end % DIM(sineValues));
+      else
+        end = DIM(sineValues);
+      for (int k=-1; k<=1; k+=2) {
+        int result = (double(end) - toneIdx) / tone.step + k*1e-6;
+        minPoints = min(minPoints, result);
+        points = max(points, result);
+      }
+    }
+  }
+
+  for (int i=0; i<points; i++) {
+    int indexes[] = { int(toneIdx - 1e-6), int(toneIdx + 1e-6) };
+    for (int j=0; j<2; j++) {
+      int16_t value = limit<int>(-32768, sineValues[indexes[j] % DIM(sineValues)] / tone.volume, 32767);
+      if (j == 0 || value < low[i]) low[i] = value;
+      if (j == 0 || value > high[i]) high[i] = value;
+    }
+    if (i >= minPoints) {
+      low[i] = min<int16_t>(low[i], 0);
+      high[i] = max<int16_t>(high[i], 0);
+    }
+    toneIdx += tone.step;
+    if ((unsigned int)toneIdx >= DIM(sineValues))
+      toneIdx -= DIM(sineValues);
+  }
+
+  tone.idx = toneIdx;
+  tone.stateDuration = (remainingDuration > AUDIO_BUFFER_DURATION ? tone.stateDuration + AUDIO_BUFFER_DURATION : 32000);
+}
+
+void checkTone(uint16_t freq, uint16_t duration, int8_t freqIncr, int volume)
+{
+  static ToneContext context;
+  AudioFragment fragment;
+  fragment.clear();
+  fragment.type = FRAGMENT_TONE;
+  fragment.tone.freq = freq;
+  fragment.tone.duration = duration;
+  fragment.tone.freqIncr = freqIncr;
+  context.setFragment(fragment);
+
+  ReferenceTone reference;
+  memset(&reference, 0, sizeof(reference));
+  reference.freq = freq;
+  reference.duration = duration;
+  reference.freqIncr = freqIncr;
+
+  int buffers = 0;
+  while (context.fragment.type == FRAGMENT_TONE) {
+    int16_t samples[AUDIO_BUFFER_SIZE], low[AUDIO_BUFFER_SIZE], high[AUDIO_BUFFER_SIZE];
+    for (int i=0; i<AUDIO_BUFFER_SIZE; i++) {
+      samples[i] = low[i] = high[i] = 0;
+    }
+    int count = context.renderBuffer(samples, volume, 0);
+    EXPECT_GT(count, 0);
+    renderReferenceTone(reference, volume, low, high);
+    for (int i=0; i<AUDIO_BUFFER_SIZE; i++) {
+      EXPECT_LE(samples[i], high[i]+1) << "freq=" << freq << " volume=" << volume << " buffer=" << buffers << " sample=" << i;
+      EXPECT_GE(samples[i]+1, low[i]) << "freq=" << freq << " volume=" << volume << " buffer=" << buffers << " sample=" << i;
+    }
+    ASSERT_LT(++buffers, 1000);
+  }
+  EXPECT_EQ(buffers, (duration + AUDIO_BUFFER_DURATION - 1) / AUDIO_BUFFER_DURATION);
+}
+
+TEST(Audio, toneSynthesis)
+{
+  for (int volume=-2; volume<=2; volume++) {
+    checkTone(BEEP_DEFAULT_FREQ, 40, 0, volume);
+    checkTone(BEEP_KEY_UP_FREQ, 25, 0, volume);
+    checkTone(BEEP_KEY_DOWN_FREQ, 25, 0, volume);
+    checkTone(440, 1000, 0, volume);
+    checkTone(1234, 95, 0, volume);
+    checkTone(5000, 15, 0, volume);
+    checkTone(300, 200, 0, volume);
+    checkTone(1000, 300, 5, volume);  // sweep up
+    checkTone(2000, 200, -8, volume); // sweep down
+  }
+
+  // the lowest tones are louder, they saturate at the highest volume
+  for (int volume=-2; volume<=2; volume++) {
+    checkTone(BEEP_MIN_FREQ, 100, 0, volume);
+    checkTone(200, 100, 0, volume);
+  }
+}
+
+TEST(Audio, latencyHistogram)
+{
+  EXPECT_EQ(audioLatencyBucket(0), 0);
+  EXPECT_EQ(audioLatencyBucket(999), 0);
+  EXPECT_EQ(audioLatencyBucket(1000), 1);
+  EXPECT_EQ(audioLatencyBucket(3999), 2);
+  EXPECT_EQ(audioLatencyBucket(4000), 3);
+  EXPECT_EQ(audioLatencyBucket(63999), 6);
+  EXPECT_EQ(audioLatencyBucket(64000), 7);
+  EXPECT_EQ(audioLatencyBucket(10000000), 7);
+
+  AudioLatencyHistogram histogram;
+  memset(&histogram, 0, sizeof(histogram));
+  histogram.record(500);
+  histogram.record(12000);
+  histogram.record(2500);
+  EXPECT_EQ(histogram.count, 3u);
+  EXPECT_EQ(histogram.max, 12000u);
+  EXPECT_EQ(histogram.buckets[0], 1u);
+  EXPECT_EQ(histogram.buckets[2], 1u);
+  EXPECT_EQ(histogram.buckets[4], 1u);
+}
+
+TEST(Audio, mixSamplesSaturation)
+{
+  int16_t result[AUDIO_BUFFER_SIZE], samples[AUDIO_BUFFER_SIZE];
+  for (int i=0; i<AUDIO_BUFFER_SIZE; i++) {
+    result[i] = (i % 3 == 0 ? 30000 : (i % 3 == 1 ? -30000 : i));
+    samples[i] = (i % 3 == 0 ? 10000 : (i % 3 == 1 ? -10000 : -i));
+  }
+
+  // an odd count, the last samples are mixed after the SIMD blocks
+  mixSamples(result, samples, AUDIO_BUFFER_SIZE-1);
+  for (int i=0; i<AUDIO_BUFFER_SIZE-1; i++) {
+    EXPECT_EQ(result[i], (i % 3 == 0 ? 32767 : (i % 3 == 1 ? -32768 : 0))) << "sample=" << i;
+  }
+  EXPECT_EQ(result[AUDIO_BUFFER_SIZE-1], (AUDIO_BUFFER_SIZE-1) % 3 == 0 ? 30000 : ((AUDIO_BUFFER_SIZE-1) % 3 == 1 ? -30000 : AUDIO_BUFFER_SIZE-1));
+}
+#endif
+
+#if defined(CPUARM) && defined(SDCARD)
+TEST(AudioCache, lruEviction)
+{
+  static AudioCache cache;
+  memset(&cache, 0, sizeof(cache));
+
+  WavHeader header = { 6 /*alaw*/, 4, 44, AUDIO_CACHE_MAX_FILE_SIZE };
+  g_tmr10ms = 100;
+  AudioCacheEntry * a = cache.add("a.wav", header);
+  g_tmr10ms = 200;
+  AudioCacheEntry * b = cache.add("b.wav", header);
+  EXPECT_EQ(cache.used(), (uint32_t)AUDIO_CACHE_SIZE);
+  EXPECT_NE(a->dataSize, 0u);
+  EXPECT_NE(b->dataSize, 0u);
+
+  // "a" becomes the most recently used
+  g_tmr10ms = 300;
+  EXPECT_EQ(cache.find("a.wav"), a);
+
+  // "b" samples are released, its header is kept
+  g_tmr10ms = 400;
+  AudioCacheEntry * c = cache.add("c.wav", header);
+  EXPECT_NE(c->dataSize, 0u);
+  EXPECT_NE(a->dataSize, 0u);
+  EXPECT_EQ(b->dataSize, 0u);
+  EXPECT_EQ(cache.find("b.wav"), b);
+  EXPECT_EQ(cache.used(), (uint32_t)AUDIO_CACHE_SIZE);
+}
+
+TEST(AudioCache, samplesLoading)
+{
+  static AudioCache cache;
+  memset(&cache, 0, sizeof(cache));
+
+  WavHeader header = { 6 /*alaw*/, 4, 44, 1000 };
+  AudioCacheEntry * a = cache.add("a.wav", header);
+  uint8_t samples[600];
+  for (unsigned int i=0; i<sizeof(samples); i++) {
+    samples[i] = i;
+  }
+
+  cache.load(a, 0, samples, 600);
+  EXPECT_FALSE(a->isComplete());
+  cache.load(a, 0, samples, 400);   // not contiguous, ignored
+  EXPECT_EQ(a->loaded, 600u);
+  cache.load(a, 600, samples, 400);
+  EXPECT_TRUE(a->isComplete());
+  EXPECT_EQ(cache.getData(a)[599], 599 & 0xFF);
+  EXPECT_EQ(cache.getData(a)[600], 0);
+
+  // long files only get their header cached
+  header.size = AUDIO_CACHE_MAX_FILE_SIZE + 1;
+  AudioCacheEntry * b = cache.add("b.wav", header);
+  EXPECT_EQ(b->dataSize, 0u);
+  EXPECT_FALSE(b->isComplete());
+  EXPECT_EQ(cache.used(), 1000u);
+}
+
+// reference IMA-ADPCM encoder, as in the Companion sound packs transcoding, it also returns the samples it expects from the decoder
+int encodeAdpcm(const int16_t * samples, int count, int blockSize, uint8_t * result, int16_t * expected)
+{
+  static const int indexes[16] = { -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8 };
+  static const int steps[89] = { 7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767 };
+  int predictor = 0, index = 0, size = 0, i = 0;
+  while (i < count) {
+    predictor = samples[i];
+    expected[i++] = predictor;
+    result[size++] = predictor & 0xFF;
+    result[size++] = (predictor >> 8) & 0xFF;
+    result[size++] = index;
+    result[size++] = 0;
+    for (int j=0; j<(blockSize-4)*2 && i<count; j++, i++) {
+      int step = steps[index];
+      int delta = samples[i] - predictor;
+      int nibble = 0, diff = step >> 3;
+      if (delta < 0) { nibble = 8; delta = -delta; }
+      if (delta >= step) { nibble |= 4; delta -= step; diff += step; }
+      if (delta >= step/2) { nibble |= 2; delta -= step/2; diff += step >> 1; }
+      if (delta >= step/4) { nibble |= 1; diff += step >> 2; }
+      predictor = limit(-32768, (nibble & 8) ? predictor - diff : predictor + diff, 32767);
+      index = limit(0, index + indexes[nibble], 88);
+      expected[i] = predictor;
+      if (j & 1)
+        result[size-1] |= nibble << 4;
+      else
+        result[size++] = nibble;
+    }
+  }
+  return size;
+}
+
+TEST(Audio, adpcmDecoding)
+{
+  // 8 full blocks of 121 samples, and a last one which ends on a byte boundary
+  const int blockSize = 64;
+  const int count = 8*121 + 33;
+  int16_t samples[count];
+  for (int i=0; i<count; i++) {
+    samples[i] = 8000 * sin(i * 2 * M_PI * 440 / 8000) + 4000 * sin(i * 2 * M_PI * 1230 / 8000);
+  }
+  uint8_t data[600];
+  int16_t expected[count];
+  int size = encodeAdpcm(samples, count, blockSize, data, expected);
+  EXPECT_LE(size, 600);
+
+  // in one go
+  int16_t decoded[1200];
+  AdpcmState state;
+  memset(&state, 0, sizeof(state));
+  state.blockSize = blockSize;
+  EXPECT_EQ(decodeAdpcm(state, data, size, decoded, DIM(decoded), 0), (unsigned int)count);
+  for (int i=0; i<count; i++) {
+    EXPECT_EQ(decoded[i], expected[i]) << "sample=" << i;
+  }
+
+  // the same samples when the reads split the blocks, with the volume shift
+  int16_t chunks[1200];
+  memset(&state, 0, sizeof(state));
+  state.blockSize = blockSize;
+  unsigned int decodedCount = 0;
+  for (int i=0; i<size; i+=7) {
+    decodedCount += decodeAdpcm(state, &data[i], min(7, size-i), &chunks[decodedCount], DIM(chunks)-decodedCount, 1);
+  }
+  EXPECT_EQ(decodedCount, (unsigned int)count);
+  for (int i=0; i<count; i++) {
+    EXPECT_EQ(chunks[i], expected[i] >> 1) << "sample=" << i;
+  }
+
+  // reads sized to give the same number of samples each time, whatever the blocks headers they contain
+  static const unsigned int samplesPerRead[] = { 160, 80, 7 };
+  for (unsigned int n=0; n<DIM(samplesPerRead); n++) {
+    memset(&state, 0, sizeof(state));
+    state.blockSize = blockSize;
+    int pos = 0;
+    decodedCount = 0;
+    while (true) {
+      unsigned int readSize = getAdpcmReadSize(state, samplesPerRead[n]);
+      if (pos + (int)readSize > size) {
+        break;
+      }
+      EXPECT_EQ(decodeAdpcm(state, &data[pos], readSize, &chunks[decodedCount], samplesPerRead[n], 0), samplesPerRead[n]) << "pos=" << pos;
+      pos += readSize;
+      decodedCount += samplesPerRead[n];
+    }
+    EXPECT_GT(decodedCount, (unsigned int)count - samplesPerRead[n] - 1);
+    for (unsigned int i=0; i<decodedCount; i++) {
+      EXPECT_EQ(chunks[i], expected[i]) << "sample=" << i << " samplesPerRead=" << samplesPerRead[n];
+    }
+  }
+}
+#endif
@@ -189,6 +189,76 @@ TEST(FrSky, HubAltNegative)
   processHubPacket(BARO_ALT_AP_ID, 05);
   EXPECT_EQ(telemetryItems[0].value, 120); 
 }
+
+TEST(FrSky, sensorHistory)
+{
+  TelemetryHistoryBucket buckets[TELEMETRY_HISTORY_BUCKETS];
+
+  MODEL_RESET();
+  TELEMETRY_RESET();
+
+  TelemetrySensor & sensor = g_model.telemetrySensors[0];
+  sensor.init("Tst");
+  EXPECT_EQ(readTelemetryHistory(0, TELEMETRY_HISTORY_RAW, buckets, DIM(buckets)), 0);
+
+  // one value every 100ms during 25s
+  sensor.history = 1;
+  for (int t=0; t<=2500; t+=10) {
+    g_tmr10ms = t;
+    telemetryItems[0].setValue(sensor, t/10, UNIT_RAW);
+  }
+
+  EXPECT_EQ(readTelemetryHistory(0, TELEMETRY_HISTORY_RAW, buckets, DIM(buckets)), TELEMETRY_HISTORY_RAW_SIZE);
+  EXPECT_EQ(buckets[0].avg, 250-TELEMETRY_HISTORY_RAW_SIZE+1);
+  EXPECT_EQ(buckets[TELEMETRY_HISTORY_RAW_SIZE-1].time, 2500u);
+  EXPECT_EQ(buckets[TELEMETRY_HISTORY_RAW_SIZE-1].avg, 250);
+
+  // 25 closed 1s buckets + the one being filled
+  EXPECT_EQ(readTelemetryHistory(0, TELEMETRY_HISTORY_1S, buckets, DIM(buckets)), 26);
+  EXPECT_EQ(buckets[0].time, 0u);
+  EXPECT_EQ(buckets[0].min, 0);
+  EXPECT_EQ(buckets[0].max, 9);
+  EXPECT_EQ(buckets[0].avg, 4);
+  EXPECT_EQ(buckets[24].time, 2400u);
+  EXPECT_EQ(buckets[24].avg, 244);
+  EXPECT_EQ(buckets[25].time, 2500u);
+  EXPECT_EQ(buckets[25].avg, 250);
+
+  // the newest buckets only
+  EXPECT_EQ(readTelemetryHistory(0, TELEMETRY_HISTORY_1S, buckets, 2), 2);
+  EXPECT_EQ(buckets[0].time, 2400u);
+  EXPECT_EQ(buckets[1].time, 2500u);
+
+  // 2 closed 10s buckets + the one being filled with the 1s buckets closed so far
+  EXPECT_EQ(readTelemetryHistory(0, TELEMETRY_HISTORY_10S, buckets, DIM(buckets)), 3);
+  EXPECT_EQ(buckets[0].time, 0u);
+  EXPECT_EQ(buckets[0].min, 0);
+  EXPECT_EQ(buckets[0].max, 99);
+  EXPECT_EQ(buckets[0].avg, 49);
+  EXPECT_EQ(buckets[1].time, 1000u);
+  EXPECT_EQ(buckets[1].min, 100);
+  EXPECT_EQ(buckets[1].max, 199);
+  EXPECT_EQ(buckets[2].time, 2000u);
+  EXPECT_EQ(buckets[2].min, 200);
+  EXPECT_EQ(buckets[2].max, 249);
+
+  // the slot is released when the option is disabled
+  sensor.history = 0;
+  telemetryItems[0].setValue(sensor, 0, UNIT_RAW);
+  EXPECT_EQ(readTelemetryHistory(0, TELEMETRY_HISTORY_RAW, buckets, DIM(buckets)), 0);
+
+  // no more sensors than slots
+  for (int i=0; i<=TELEMETRY_HISTORY_SLOTS; i++) {
+    g_model.telemetrySensors[i].init("Tst");
+    g_model.telemetrySensors[i].history = 1;
+    telemetryItems[i].setValue(g_model.telemetrySensors[i], i, UNIT_RAW);
+  }
+  EXPECT_EQ(readTelemetryHistory(TELEMETRY_HISTORY_SLOTS-1, TELEMETRY_HISTORY_RAW, buckets, DIM(buckets)), 1);
+  EXPECT_EQ(readTelemetryHistory(TELEMETRY_HISTORY_SLOTS, TELEMETRY_HISTORY_RAW, buckets, DIM(buckets)), 0);
+
+  TELEMETRY_RESET();
+  EXPECT_EQ(readTelemetryHistory(0, TELEMETRY_HISTORY_RAW, buckets, DIM(buckets)), 0);
+}
 #endif  // #if defined(FRSKY) && defined(CPUARM)
 
 #if defined(FRSKY_SPORT)
@@ -420,6 +490,50 @@ TEST(FrSkySPORT, frskySetCellVoltageTwoSensors)
   g_model.frsky.voltsSource = FRSKY_VOLTS_SOURCE_A1;
 }
 
+TEST(FrSkySPORT, calculatedSensorsChain)
+{
+  MODEL_RESET();
+  TELEMETRY_RESET();
+
+  g_model.telemetrySensors[0].init("A");
+  g_model.telemetrySensors[1].init("B");
+
+  // sensor 3 depends on sensor 4, which is evaluated first
+  g_model.telemetrySensors[2].init("Max");
+  g_model.telemetrySensors[2].type = TELEM_TYPE_CALCULATED;
+  g_model.telemetrySensors[2].formula = TELEM_FORMULA_MAX;
+  g_model.telemetrySensors[2].calc.sources[0] = 4;
+  g_model.telemetrySensors[2].calc.sources[1] = 4;
+  g_model.telemetrySensors[3].init("Sum");
+  g_model.telemetrySensors[3].type = TELEM_TYPE_CALCULATED;
+  g_model.telemetrySensors[3].formula = TELEM_FORMULA_ADD;
+  g_model.telemetrySensors[3].calc.sources[0] = 1;
+  g_model.telemetrySensors[3].calc.sources[1] = 2;
+
+  telemetryItems[0].setValue(g_model.telemetrySensors[0], 10, UNIT_RAW);
+  telemetryItems[1].setValue(g_model.telemetrySensors[1], 20, UNIT_RAW);
+  evalTelemetrySensors();
+  EXPECT_EQ(telemetryItems[3].value, 30);
+  EXPECT_EQ(telemetryItems[2].value, 30);
+
+  // nothing is evaluated when no source has changed
+  telemetryItems[3].value = 0;
+  evalTelemetrySensors();
+  EXPECT_EQ(telemetryItems[3].value, 0);
+
+  telemetryItems[1].setValue(g_model.telemetrySensors[1], 5, UNIT_RAW);
+  evalTelemetrySensors();
+  EXPECT_EQ(telemetryItems[3].value, 15);
+  EXPECT_EQ(telemetryItems[2].value, 15);
+
+  // a source which becomes old makes its dependents old
+  telemetryItems[0].lastReceived = TELEMETRY_VALUE_OLD;
+  telemetrySensorUpdated(0);
+  evalTelemetrySensors();
+  EXPECT_TRUE(telemetryItems[3].isOld());
+  EXPECT_TRUE(telemetryItems[2].isOld());
+}
+
 void generateSportFasVoltagePacket(uint8_t * packet, uint32_t voltage)
 {
   packet[0] = 0x22; //DATA_ID_FAS
@@ -523,4 +637,251 @@ TEST(FrSkySPORT, frskyCurrent)
   EXPECT_EQ(telemetryItems[0].valueMax, 505);
 }
 
+TEST(FrSkySPORT, sensorsIndex)
+{
+  MODEL_RESET();
+  TELEMETRY_RESET();
+  allowNewSensors = true;
+
+  setTelemetryValue(TELEM_PROTO_FRSKY_SPORT, T1_FIRST_ID, 1, 20, UNIT_CELSIUS, 0);
+  setTelemetryValue(TELEM_PROTO_FRSKY_SPORT, T1_FIRST_ID, 2, 30, UNIT_CELSIUS, 0);
+  setTelemetryValue(TELEM_PROTO_FRSKY_SPORT, RSSI_ID, 0, 80, UNIT_RAW, 0);
+  setTelemetryValue(TELEM_PROTO_FRSKY_SPORT, GPS_COURS_FIRST_ID, 0, 90, UNIT_DEGREE, 0);
+  EXPECT_EQ(g_model.telemetrySensors[0].instance, 1);
+  EXPECT_EQ(g_model.telemetrySensors[1].instance, 2);
+  EXPECT_EQ(g_model.telemetrySensors[0].unit, UNIT_CELSIUS);
+  EXPECT_EQ(g_model.telemetrySensors[2].unit, UNIT_DB);
+  EXPECT_EQ(g_model.telemetrySensors[3].unit, UNIT_DEGREE);
+  EXPECT_EQ(telemetryItems[0].value, 20);
+  EXPECT_EQ(telemetryItems[1].value, 30);
+
+  // a copy of the second sensor gets the same values
+  memcpy(&g_model.telemetrySensors[4], &g_model.telemetrySensors[1], sizeof(TelemetrySensor));
+  eeDirty(EE_MODEL);
+  setTelemetryValue(TELEM_PROTO_FRSKY_SPORT, T1_FIRST_ID, 2, 35, UNIT_CELSIUS, 0);
+  EXPECT_EQ(telemetryItems[0].value, 20);
+  EXPECT_EQ(telemetryItems[1].value, 35);
+  EXPECT_EQ(telemetryItems[4].value, 35);
+
+  g_model.ignoreSensorIds = 1;
+  eeDirty(EE_MODEL);
+  setTelemetryValue(TELEM_PROTO_FRSKY_SPORT, T1_FIRST_ID, 7, 40, UNIT_CELSIUS, 0);
+  EXPECT_EQ(telemetryItems[0].value, 40);
+  EXPECT_EQ(telemetryItems[1].value, 40);
+  EXPECT_EQ(telemetryItems[4].value, 40);
+  EXPECT_FALSE(g_model.telemetrySensors[5].isAvailable());
+}
+
+#if defined(PCBTARANIS)
+extern uint8_t telemetryProtocol;
+extern uint8_t frskyDataState;
+extern uint8_t frskyRxBufferCount;
+void processSerialData(uint8_t data);
+
+int appendSportFrame(uint8_t * stream, const uint8_t * packet)
+{
+  int len = 0;
+  stream[len++] = START_STOP;
+  for (int i=0; i<FRSKY_SPORT_PACKET_SIZE; i++) {
+    if (packet[i] == START_STOP || packet[i] == BYTESTUFF) {
+      stream[len++] = BYTESTUFF;
+      stream[len++] = packet[i] ^ STUFF_MASK;
+    }
+    else {
+      stream[len++] = packet[i];
+    }
+  }
+  return len;
+}
+
+int generateSportStream(uint8_t * stream)
+{
+  // captured frames, the altitude one needs byte stuffing
+  static const uint8_t captured[][FRSKY_SPORT_PACKET_SIZE] = {
+    { 0x98, 0x10, 0x10, 0x00, 0x7E, 0x02, 0x00, 0x00, 0x5F },
+    { 0x98, 0x10, 0x06, 0x00, 0x07, 0xD0, 0x00, 0x00, 0x12 },
+    { 0x98, 0x10, 0x06, 0x00, 0x17, 0xD0, 0x00, 0x00, 0x02 },
+    { 0x98, 0x10, 0x06, 0x00, 0x27, 0xD0, 0x00, 0x00, 0xF1 },
+  };
+  uint8_t packet[FRSKY_SPORT_PACKET_SIZE];
+  int len = 0;
+
+  for (unsigned int i=0; i<DIM(captured); i++) {
+    len += appendSportFrame(stream+len, captured[i]);
+    // receiver polls without answer
+    stream[len++] = START_STOP;
+    stream[len++] = 0x1B;
+  }
+  generateSportCellPacket(packet, 4, 0, _V(410), _V(420), DATA_ID_FLVSS+1);
+  len += appendSportFrame(stream+len, packet);
+  generateSportCellPacket(packet, 4, 2, _V(400), _V(405), DATA_ID_FLVSS+1);
+  len += appendSportFrame(stream+len, packet);
+  return len;
+}
+
+void resetSportDecoder()
+{
+  MODEL_RESET();
+  TELEMETRY_RESET();
+  allowNewSensors = true;
+  telemetryProtocol = PROTOCOL_FRSKY_SPORT;
+  frskyDataState = STATE_DATA_IDLE;
+  frskyRxBufferCount = 0;
+}
+
+TEST(FrSkySPORT, serialSpanDecoder)
+{
+  uint8_t stream[256];
+  int len = generateSportStream(stream);
+
+  resetSportDecoder();
+  for (int i=0; i<len; i++) {
+    processSerialData(stream[i]);
+  }
+  int32_t values[MAX_SENSORS];
+  for (int i=0; i<MAX_SENSORS; i++) {
+    values[i] = telemetryItems[i].value;
+  }
+  EXPECT_TRUE(g_model.telemetrySensors[1].isAvailable());
+  EXPECT_EQ(telemetryItems[1].cells.count, 4);
+  EXPECT_EQ(telemetryItems[1].value, 1635);
+
+  for (int chunk=1; chunk<=len; chunk++) {
+    resetSportDecoder();
+    for (int i=0; i<len; i+=chunk) {
+      processSerialSpan(stream+i, min(chunk, len-i));
+    }
+    for (int i=0; i<MAX_SENSORS; i++) {
+      EXPECT_EQ(values[i], telemetryItems[i].value) << "sensor " << i << " chunk " << chunk;
+    }
+  }
+}
+
+#if defined(SIMU)
+#include <chrono>
+
+TEST(FrSkySPORT, serialSpanDecoderBenchmark)
+{
+  uint8_t stream[256];
+  int len = generateSportStream(stream);
+
+  for (int mode=0; mode<2; mode++) {
+    resetSportDecoder();
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (int n=0; n<10000; n++) {
+      if (mode == 0) {
+        for (int i=0; i<len; i++) {
+          processSerialData(stream[i]);
+        }
+      }
+      else {
+        processSerialSpan(stream, len);
+      }
+    }
+    std::chrono::nanoseconds duration = std::chrono::high_resolution_clock::now() - start;
+    EXPECT_EQ(telemetryItems[1].value, 1635);
+    printf("S.Port %s decoder x %d bytes: %lldus\n", mode == 0 ? "byte" : "span", 10000*len, (long long)duration.count() / 1000);
+  }
+}
+#endif
+#endif
+
 #endif  //#if defined(FRSKY_SPORT)
+
+#if defined(CPUARM)
+TEST(Fifo, bulkPushPop)
+{
+  Fifo<16> fifo;
+  uint8_t data[32];
+  uint8_t result[32];
+  for (int i=0; i<32; i++) {
+    data[i] = i;
+  }
+
+  EXPECT_EQ(fifo.push(data, 10), 10U);
+  EXPECT_EQ(fifo.pop(result, 6), 6U);
+  EXPECT_EQ(memcmp(data, result, 6), 0);
+
+  // wraps around the end of the buffer, 15 bytes max
+  EXPECT_EQ(fifo.push(data+10, 12), 11U);
+  EXPECT_EQ(fifo.getOverflows(), 1U);
+  EXPECT_EQ(fifo.getHighWaterMark(), 15U);
+  EXPECT_TRUE(fifo.isFull());
+  fifo.push(0xFF);
+  EXPECT_EQ(fifo.getOverflows(), 2U);
+
+  const uint8_t * span;
+  EXPECT_EQ(fifo.getSpan(span), 10U);
+  EXPECT_EQ(span[0], 6);
+  EXPECT_EQ(fifo.pop(result, 32), 15U);
+  EXPECT_EQ(memcmp(data+6, result, 15), 0);
+  EXPECT_TRUE(fifo.isEmpty());
+
+  fifo.resetStats();
+  EXPECT_EQ(fifo.getOverflows(), 0U);
+  EXPECT_EQ(fifo.getHighWaterMark(), 0U);
+}
+
+#define DEG2RAD(x) ((x) * M_PI / 180)
+#define RAD2DEG(x) ((x) * 180 / M_PI)
+
+void gpsDestination(double lat, double lon, double distance, double bearing, double * lat2, double * lon2)
+{
+  double d = distance / 6371000.0;
+  double b = DEG2RAD(bearing);
+  double phi = asin(sin(DEG2RAD(lat))*cos(d) + cos(DEG2RAD(lat))*sin(d)*cos(b));
+  double lambda = DEG2RAD(lon) + atan2(sin(b)*sin(d)*cos(DEG2RAD(lat)), cos(d)-sin(DEG2RAD(lat))*sin(phi));
+  *lat2 = RAD2DEG(phi);
+  *lon2 = fmod(RAD2DEG(lambda) + 540, 360) - 180;
+}
+
+double gpsHaversine(double lat1, double lon1, double lat2, double lon2)
+{
+  double dphi = DEG2RAD(lat2 - lat1);
+  double dlambda = DEG2RAD(lon2 - lon1);
+  double a = sin(dphi/2)*sin(dphi/2) + cos(DEG2RAD(lat1))*cos(DEG2RAD(lat2))*sin(dlambda/2)*sin(dlambda/2);
+  return 2 * 6371000.0 * atan2(sqrt(a), sqrt(1-a));
+}
+
+TEST(Gps, longitudeScale)
+{
+  for (int lat=-89; lat<=89; lat++) {
+    EXPECT_NEAR(gpsLongitudeScale(lat * 1000000) / 65536.0, cos(DEG2RAD(lat)), 2e-5) << "latitude " << lat;
+  }
+}
+
+TEST(Gps, distanceAndBearing)
+{
+  // pilot positions, including the equator and the Greenwich meridian
+  const double pilots[][2] = { {0, 0}, {45.5, 6.2}, {60.1, -1.3}, {-33.9, 151.2}, {51.48, -0.0005}, {0.0005, -70.1} };
+  const double distances[] = { 10, 100, 1000, 5000, 20000 };
+  double maxError = 0;
+
+  for (unsigned i=0; i<DIM(pilots); i++) {
+    int32_t pilotLatitude = lround(pilots[i][0] * 1000000);
+    int32_t pilotLongitude = lround(pilots[i][1] * 1000000);
+    uint32_t scale = gpsLongitudeScale(pilotLatitude);
+    for (unsigned j=0; j<DIM(distances); j++) {
+      for (int bearing=0; bearing<360; bearing+=15) {
+        double lat, lon;
+        gpsDestination(pilots[i][0], pilots[i][1], distances[j], bearing, &lat, &lon);
+        int32_t latitude = lround(lat * 1000000);
+        int32_t longitude = lround(lon * 1000000);
+        double reference = gpsHaversine(pilotLatitude / 1000000.0, pilotLongitude / 1000000.0, latitude / 1000000.0, longitude / 1000000.0);
+        int32_t east, north;
+        gpsGetOffset(pilotLatitude, pilotLongitude, scale, latitude, longitude, &east, &north);
+        double distance = gpsGetDistance(east, north);
+        EXPECT_NEAR(distance, reference, max(1.0, reference * 0.005)) << "pilot " << i << " bearing " << bearing << " distance " << distances[j];
+        if (reference >= 100) {
+          maxError = max(maxError, fabs(distance - reference) / reference);
+          int error = abs(gpsGetBearing(east, north) - bearing);
+          EXPECT_LE(min(error, 360 - error), 1) << "pilot " << i << " bearing " << bearing << " distance " << distances[j];
+        }
+      }
+    }
+  }
+
+  EXPECT_LT(maxError, 0.005);
+  EXPECT_EQ(gpsGetDistance(30, 40, 12), 13U);
+}
+#endif
@@ -38,6 +38,11 @@ inline void MODEL_RESET()
   extern uint8_t s_mixer_first_run_done;
   s_mixer_first_run_done = false;
   lastFlightMode = 255;
+  INVALIDATE_MIXER_PLAN();
+  INVALIDATE_CURVES_CACHE();
+  INVALIDATE_LOGICAL_SWITCHES_GRAPH();
+  INVALIDATE_GVARS_CACHE();
+  INVALIDATE_TELEMETRY_INDEX();
 }
 
 inline void MIXER_RESET()
@@ -54,6 +59,7 @@ inline void MIXER_RESET()
   mixerCurrentFlightMode = lastFlightMode = 0;
   lastAct = 0;
   logicalSwitchesReset();
+  INVALIDATE_MIXER_PLAN();
 }
 
 inline void TELEMETRY_RESET()
@@ -66,6 +72,7 @@ inline void TELEMETRY_RESET()
   for (int i=0; i<MAX_SENSORS; i++) {
     telemetryItems[i].clear();
   }
+  telemetryHistoryReset();
 #endif
 }
 
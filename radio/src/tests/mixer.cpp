@@ -441,6 +441,146 @@ TEST(Curves, LinearIntpol)
   EXPECT_EQ(applyCustomCurve(-192, 0), -192);
 }
 
+#if defined(XCURVES)
+uint32_t curveChecksum(uint8_t idx)
+{
+  uint32_t result = 0;
+  for (int x=-RESX-8; x<=RESX+8; x++) {
+    result = result * 31 + (uint16_t)applyCustomCurve(x, idx);
+  }
+  return result;
+}
+
+TEST(Curves, CachedEvaluation)
+{
+  static const int8_t points[] = {
+    -100, -60, 10, 45, 100,                                         // 0: standard, 5 points
+    -80, 100, 20, -50, 0, 70, 90, -60, -30, 0, 20, 65,              // 1: custom, 7 points
+    100, 90, 70, 40, 0, -40, -70, -90, -100, -75, -50, 0, 25, 50, 75, 90, 100, // 2: standard, 17 points
+    0, 0, 30, 30, 30, -100, -25, -25, 0, 60,                        // 3: custom, duplicate X
+    -100, -50, 0, 50, 100, 20, -40, 60,                             // 4: custom, X not sorted
+  };
+  MODEL_RESET();
+  memcpy(g_model.points, points, sizeof(points));
+  g_model.curves[0].points = 0;
+  g_model.curves[1].type = CURVE_TYPE_CUSTOM;
+  g_model.curves[1].points = 2;
+  g_model.curves[2].points = 12;
+  g_model.curves[3].type = CURVE_TYPE_CUSTOM;
+  g_model.curves[3].points = 1;
+  g_model.curves[4].type = CURVE_TYPE_CUSTOM;
+  g_model.curves[4].points = 0;
+  loadCurves();
+
+  static const uint32_t expected[2][5] = {
+    { 1494955123u, 1860952686u, 259173631u, 1394695101u, 4144842557u },
+    { 851634495u, 860580267u, 1344356547u, 2751748703u, 1456706984u },
+  };
+  for (int smooth=0; smooth<=1; smooth++) {
+    for (int i=0; i<5; i++) {
+      g_model.curves[i].smooth = smooth;
+      EXPECT_EQ(curveChecksum(i), expected[smooth][i]) << "curve " << i << " smooth " << smooth;
+    }
+  }
+}
+
+TEST(Curves, CacheRebuiltAfterEdit)
+{
+  static const int8_t points[] = { -100, -50, 0, 50, 100, -50, 0, 50 };  // custom, 5 points
+  MODEL_RESET();
+  memcpy(g_model.points, points, sizeof(points));
+  g_model.curves[0].type = CURVE_TYPE_CUSTOM;
+  g_model.curves[0].points = 0;
+  loadCurves();
+  applyCustomCurve(0, 0);
+
+  // checkIncDec() calls eeDirty() before the menu stores the value, the mixer may run in between
+  eeDirty(EE_MODEL);
+  applyCustomCurve(0, 0);
+  g_model.points[6] = -20;
+  eeCheckEdited();
+  uint32_t checksum = curveChecksum(0);
+  loadCurves();
+  EXPECT_EQ(checksum, curveChecksum(0));
+}
+#endif
+
+#if defined(CPUARM)
+TEST(Curves, ExpoBatch)
+{
+  int values[2*RESX+1];
+  for (int k=-100; k<=100; k++) {
+    for (int x=-RESX; x<=RESX; x++) {
+      values[RESX+x] = x;
+    }
+    // batches of 1 to 9 values, both the vectorized loop and the remaining values are exercised
+    for (int first=0, count=1; first<2*RESX+1; first+=count, count=count%9+1) {
+      expoBatch(&values[first], min(count, 2*RESX+1-first), k);
+    }
+    for (int x=-RESX; x<=RESX; x++) {
+      ASSERT_EQ(expo(x, k), values[RESX+x]) << "x=" << x << " k=" << k;
+    }
+  }
+}
+
+TEST(Mixer, BatchedExpos)
+{
+  static const int8_t expos[NUM_STICKS] = { 30, -40, 30, 0 };
+  MODEL_RESET();
+  modelDefault(0);
+  for (int i=0; i<NUM_STICKS; i++) {
+    ExpoData * expo = expoAddress(i);
+#if !defined(VIRTUALINPUTS)
+    expo->chn = i;
+    expo->mode = 3;
+    expo->weight = 100;
+    expo->curveMode = MODE_EXPO;
+#endif
+    anaInValues[i] = 300*i - 500;
+  }
+  evalMixes(1);
+  int16_t linear[NUM_STICKS];
+  memcpy(linear, anas, sizeof(linear));
+
+  for (int i=0; i<NUM_STICKS; i++) {
+#if defined(VIRTUALINPUTS)
+    expoAddress(i)->curve.value = expos[i];
+#else
+    expoAddress(i)->curveParam = expos[i];
+#endif
+  }
+  evalMixes(1);
+  for (int i=0; i<NUM_STICKS; i++) {
+    EXPECT_EQ(expo(linear[i], expos[i]), anas[i]) << "input " << i;
+  }
+}
+
+TEST(Mixer, QuiescentInputs)
+{
+  MODEL_RESET();
+  modelDefault(0);
+  s_mixer_first_run_done = true;
+  anaInValues[ELE_STICK] = 500;
+  evalMixes(1);
+  EXPECT_FALSE(isMixerQuiescent(1));
+  evalMixes(0);
+  EXPECT_TRUE(isMixerQuiescent(0));
+  int16_t outputs[NUM_CHNOUT];
+  memcpy(outputs, channelOutputs, sizeof(outputs));
+
+  anaInValues[ELE_STICK] = -500;
+  EXPECT_FALSE(isMixerQuiescent(0));
+  evalMixes(0);
+  EXPECT_NE(0, memcmp(outputs, channelOutputs, sizeof(outputs)));
+  EXPECT_FALSE(isMixerQuiescent(0));
+  evalMixes(0);
+  EXPECT_TRUE(isMixerQuiescent(0));
+
+  eeDirty(EE_GENERAL);
+  EXPECT_FALSE(isMixerQuiescent(0));
+}
+#endif
+
 
 #if !defined(CPUARM)
 TEST(FlightModes, nullFadeOut_posFadeIn)
@@ -554,6 +694,46 @@ TEST(Mixer, Cascaded5Channels)
 }
 #endif
 
+#if defined(CPUARM)
+TEST(Mixer, CascadedReversedChannels)
+{
+  MODEL_RESET();
+  MIXER_RESET();
+  for (int i=0; i<8; i++) {
+    g_model.mixData[i].destCh = i;
+    g_model.mixData[i].srcRaw = (i == 7 ? MIXSRC_MAX : MIXSRC_CH2+i);
+    g_model.mixData[i].weight = 100;
+  }
+  evalFlightModeMixes(e_perout_mode_normal, 0);
+  EXPECT_EQ(mixerPlanState, MIXER_PLAN_SORTED);
+  for (int i=0; i<8; i++) {
+    EXPECT_EQ(chans[i], CHANNEL_MAX);
+  }
+}
+
+TEST(Mixer, PlanRebuiltAfterEdit)
+{
+  MODEL_RESET();
+  MIXER_RESET();
+  g_model.mixData[0].destCh = 0;
+  g_model.mixData[0].srcRaw = MIXSRC_MAX;
+  g_model.mixData[0].weight = 100;
+  g_model.mixData[1].destCh = 1;
+  g_model.mixData[1].srcRaw = MIXSRC_MAX;
+  g_model.mixData[1].weight = -100;
+  evalFlightModeMixes(e_perout_mode_normal, 0);
+  EXPECT_EQ(chans[0], CHANNEL_MAX);
+
+  // checkIncDec() calls eeDirty() before the menu stores the value, the mixer may run in between
+  eeDirty(EE_MODEL);
+  evalFlightModeMixes(e_perout_mode_normal, 0);
+  g_model.mixData[0].srcRaw = MIXSRC_CH2;
+  eeCheckEdited();
+  evalFlightModeMixes(e_perout_mode_normal, 0);
+  EXPECT_EQ(chans[0], -CHANNEL_MAX);
+}
+#endif
+
 TEST(Mixer, InfiniteRecursiveChannels)
 {
   MODEL_RESET();
@@ -1024,3 +1204,157 @@ TEST(Trainer, UnpluggedTest)
   ppmInput[0] = 1024;
   CHECK_DELAY(0, 5000);
 }
+
+#if defined(CPUARM)
+TEST(FlightModes, FadeBlending)
+{
+  MODEL_RESET();
+  MIXER_RESET();
+  g_model.mixData[0].destCh = 0;
+  g_model.mixData[0].srcRaw = MIXSRC_MAX;
+  g_model.mixData[0].flightModes = 0b11110;
+  g_model.mixData[0].weight = 100;
+  g_model.mixData[1].destCh = 0;
+  g_model.mixData[1].srcRaw = MIXSRC_MAX;
+  g_model.mixData[1].flightModes = 0b11101;
+  g_model.mixData[1].weight = -100;
+
+  // no fade to start from FM0 alone
+  g_model.flightModeData[1].swtch = SWSRC_ON;
+  evalMixes(1);
+  g_model.flightModeData[1].swtch = SWSRC_NONE;
+  evalMixes(1);
+  EXPECT_EQ(channelOutputs[0], 1024);
+
+  // 1s fade to FM1
+  g_model.flightModeData[1].fadeIn = 10;
+  g_model.flightModeData[1].swtch = SWSRC_ON;
+  int previous = 1024;
+  for (int i=0; i<110; i++) {
+    evalMixes(1);
+    EXPECT_LE(channelOutputs[0], previous);
+    previous = channelOutputs[0];
+    if (i == 50) {
+      EXPECT_NEAR(channelOutputs[0], 0, 2);
+    }
+  }
+  EXPECT_EQ(channelOutputs[0], -1024);
+}
+
+TEST(Sources, getValue)
+{
+  MODEL_RESET();
+  MIXER_RESET();
+  memclear(ppmInput, sizeof(ppmInput));
+  memclear(g_eeGeneral.trainer.calib, sizeof(g_eeGeneral.trainer.calib));
+  ppmInput[0] = 400;
+  ppmInput[NUM_CAL_PPM] = 400;
+  g_eeGeneral.trainer.calib[0] = 100;
+  EXPECT_EQ(getValue(MIXSRC_FIRST_TRAINER), 600);
+  EXPECT_EQ(getValue(MIXSRC_FIRST_TRAINER+NUM_CAL_PPM), 800);
+  ppmInput[0] = ppmInput[NUM_CAL_PPM] = 0;
+  g_eeGeneral.trainer.calib[0] = 0;
+
+#if defined(GVARS)
+  g_model.flightModeData[0].gvars[0] = 50;
+  g_model.flightModeData[1].gvars[0] = GVAR_MAX+1;   // same value as FM0
+  g_model.flightModeData[1].gvars[1] = -30;
+  mixerCurrentFlightMode = 1;
+  EXPECT_EQ(getValue(MIXSRC_GVAR1), 50);
+  EXPECT_EQ(getValue(MIXSRC_GVAR1+1), -30);
+  mixerCurrentFlightMode = 0;
+  EXPECT_EQ(getValue(MIXSRC_GVAR1+1), 0);
+
+#if defined(CPUARM)
+  g_model.flightModeData[2].gvars[0] = GVAR_MAX+2;   // same value as FM1, then FM0
+  g_model.flightModeData[2].gvars[1] = GVAR_MAX+2;   // same value as FM1
+  updateGVarsCache();
+  mixerCurrentFlightMode = 2;
+  EXPECT_EQ(getValue(MIXSRC_GVAR1), 50);
+  EXPECT_EQ(getValue(MIXSRC_GVAR1+1), -30);
+  g_model.flightModeData[1].gvars[1] = 40;
+  EXPECT_EQ(getValue(MIXSRC_GVAR1+1), 40);
+  g_model.flightModeData[2].gvars[1] = 10;
+  eeDirty(EE_MODEL);
+  EXPECT_EQ(getValue(MIXSRC_GVAR1+1), 10);
+
+  // checkIncDec() calls eeDirty() before the menu stores the value, the mixer may run in between
+  eeDirty(EE_MODEL);
+  updateGVarsCache();
+  EXPECT_EQ(getValue(MIXSRC_GVAR1), 50);
+  g_model.flightModeData[2].gvars[0] = 20;
+  eeCheckEdited();
+  EXPECT_EQ(getValue(MIXSRC_GVAR1), 20);
+  mixerCurrentFlightMode = 0;
+#endif
+#endif
+
+  TELEMETRY_RESET();
+  telemetryItems[1].value = 120;
+  telemetryItems[1].valueMin = -5;
+  telemetryItems[1].valueMax = 300;
+  EXPECT_EQ(getValue(MIXSRC_FIRST_TELEM+3), 120);
+  EXPECT_EQ(getValue(MIXSRC_FIRST_TELEM+4), -5);
+  EXPECT_EQ(getValue(MIXSRC_FIRST_TELEM+5), 300);
+  TELEMETRY_RESET();
+
+  ex_chans[2] = -512;
+  EXPECT_EQ(getValue(MIXSRC_CH1+2), -512);
+  EXPECT_EQ(getValue(MIXSRC_MAX), 1024);
+  EXPECT_EQ(getValue(MIXSRC_NONE), 0);
+  EXPECT_EQ(getValue(MIXSRC_LAST_TELEM+1), 0);
+  ex_chans[2] = 0;
+
+#if defined(RTCLOCK)
+  g_rtcTime = 3*SECS_PER_DAY + 12*3600 + 34*60;
+  EXPECT_EQ(getValue(MIXSRC_TX_TIME), 12*60+34);
+  EXPECT_EQ(getValue(MIXSRC_RESERVE5), 12*60+34);
+  g_rtcTime = 0;
+#endif
+}
+#endif
+
+#if defined(SIMU)
+#include <chrono>
+
+TEST(Sources, getValueBenchmark)
+{
+  static const struct {
+    const char * name;
+    mixsrc_t source;
+  } sources[] = {
+#if defined(VIRTUALINPUTS)
+    { "input", MIXSRC_FIRST_INPUT },
+    { "lua", MIXSRC_FIRST_LUA },
+#endif
+    { "stick", MIXSRC_Rud },
+    { "max", MIXSRC_MAX },
+    { "cyclic", MIXSRC_CYC1 },
+    { "trim", MIXSRC_FIRST_TRIM },
+    { "switch", MIXSRC_FIRST_SWITCH+1 },
+    { "logical switch", MIXSRC_FIRST_LOGICAL_SWITCH },
+    { "trainer", MIXSRC_FIRST_TRAINER },
+    { "channel", MIXSRC_LAST_CH },
+    { "gvar", MIXSRC_LAST_GVAR },
+#if defined(CPUARM)
+    { "tx voltage", MIXSRC_TX_VOLTAGE },
+    { "timer", MIXSRC_FIRST_TIMER },
+#endif
+    { "telemetry", MIXSRC_LAST_TELEM },
+  };
+
+  MODEL_RESET();
+  MIXER_RESET();
+  for (unsigned int s=0; s<DIM(sources); s++) {
+    volatile mixsrc_t source = sources[s].source;  // volatile to keep the lookups inside the loop
+    volatile getvalue_t value;
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (int i=0; i<1000000; i++) {
+      value = getValue(source);
+    }
+    std::chrono::nanoseconds duration = std::chrono::high_resolution_clock::now() - start;
+    EXPECT_EQ(value, getValue(sources[s].source)) << sources[s].name;
+    printf("getValue(%s) x 1M: %lldus\n", sources[s].name, (long long)duration.count() / 1000);
+  }
+}
+#endif
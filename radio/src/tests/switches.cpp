@@ -379,3 +379,68 @@ TEST(evalLogicalSwitches, playFile)
   EXPECT_EQ(strcmp(filename, "/SOUNDS/en/MODEL01/L32-on.wav"), 0);
 }
 #endif
+
+#if defined(CPUARM)
+TEST(evalLogicalSwitches, incrementalEvaluation)
+{
+  MODEL_RESET();
+  MIXER_RESET();
+
+  // L1 = CH1 > 0, L2..L8 = previous AND ON, L10 = L20 OR L8
+  g_model.logicalSw[0].func = LS_FUNC_VPOS;
+  g_model.logicalSw[0].v1 = MIXSRC_CH1;
+  g_model.logicalSw[0].v2 = 0;
+  for (int i=1; i<8; i++) {
+    g_model.logicalSw[i].func = LS_FUNC_AND;
+    g_model.logicalSw[i].v1 = SWSRC_SW1+i-1;
+    g_model.logicalSw[i].v2 = SWSRC_ON;
+  }
+  g_model.logicalSw[9].func = LS_FUNC_OR;
+  g_model.logicalSw[9].v1 = SWSRC_SW1+19;
+  g_model.logicalSw[9].v2 = SWSRC_SW1+7;
+
+  logicalSwitchesEvaluated = 0;
+  evalLogicalSwitches();
+  EXPECT_EQ(logicalSwitchesEvaluated, NUM_LOGICAL_SWITCH);
+  logicalSwitchesEvaluated = 0;
+  evalLogicalSwitches();
+  EXPECT_EQ(logicalSwitchesEvaluated, 1);
+  EXPECT_EQ(getSwitch(SWSRC_SW1+9), false);
+
+  // the whole chain follows L1 in the same tick
+  ex_chans[0] = 100;
+  evalLogicalSwitches();
+  EXPECT_EQ(getSwitch(SWSRC_SW1+7), true);
+  EXPECT_EQ(getSwitch(SWSRC_SW1+9), true);
+  evalLogicalSwitches();
+  logicalSwitchesEvaluated = 0;
+  evalLogicalSwitches();
+  EXPECT_EQ(logicalSwitchesEvaluated, 1);
+  EXPECT_EQ(getSwitch(SWSRC_SW1+9), true);
+
+  // a model change rebuilds the graph
+  g_model.logicalSw[19].func = LS_FUNC_AND;
+  g_model.logicalSw[19].v1 = SWSRC_ON;
+  g_model.logicalSw[19].v2 = SWSRC_ON;
+  g_model.logicalSw[9].v2 = -SWSRC_SW1;
+  eeDirty(EE_MODEL);
+  logicalSwitchesEvaluated = 0;
+  evalLogicalSwitches();
+  EXPECT_EQ(logicalSwitchesEvaluated, NUM_LOGICAL_SWITCH);
+  EXPECT_EQ(getSwitch(SWSRC_SW1+19), true);
+
+  ex_chans[0] = 0;
+  evalLogicalSwitches();
+  EXPECT_EQ(getSwitch(SWSRC_SW1+7), false);
+  EXPECT_EQ(getSwitch(SWSRC_SW1+9), true);
+
+  // checkIncDec() calls eeDirty() before the menu stores the value, the mixer may run in between
+  eeDirty(EE_MODEL);
+  evalLogicalSwitches();
+  g_model.logicalSw[9].v1 = SWSRC_SW1+7;
+  g_model.logicalSw[9].v2 = SWSRC_SW1;
+  eeCheckEdited();
+  evalLogicalSwitches();
+  EXPECT_EQ(getSwitch(SWSRC_SW1+9), false);
+}
+#endif
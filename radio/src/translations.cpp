@@ -573,6 +573,7 @@ const pm_char STR_BLCOLOR[]  PROGMEM = TR_BLCOLOR;
   const pm_char STR_AUTOOFFSET[] PROGMEM = TR_AUTOOFFSET;
   const pm_char STR_ONLYPOSITIVE[] PROGMEM = TR_ONLYPOSITIVE;
   const pm_char STR_FILTER[] PROGMEM = TR_FILTER;
+  const pm_char STR_HISTORY[] PROGMEM = TR_HISTORY;
   const pm_char STR_TELEMETRYFULL[] PROGMEM = TR_TELEMETRYFULL;
   const pm_char STR_IGNORE_INSTANCE[] PROGMEM = TR_IGNORE_INSTANCE;
   const pm_char STR_DISCOVER_SENSORS[] PROGMEM = TR_DISCOVER_SENSORS;
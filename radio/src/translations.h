@@ -792,6 +792,7 @@ extern const pm_char STR_BLCOLOR[];
   extern const pm_char STR_AUTOOFFSET[];
   extern const pm_char STR_ONLYPOSITIVE[];
   extern const pm_char STR_FILTER[];
+  extern const pm_char STR_HISTORY[];
   extern const pm_char STR_TELEMETRYFULL[];
   extern const pm_char STR_IGNORE_INSTANCE[];
   extern const pm_char STR_DISCOVER_SENSORS[];